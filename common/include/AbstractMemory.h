@@ -0,0 +1,182 @@
+#ifndef ABSTRACT_MEMORY_H
+#define ABSTRACT_MEMORY_H
+
+#include "Domain.h"
+#include "MonotoneSolver.h"
+#include "ValueNumbering.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Abstract Memory
+//===----------------------------------------------------------------------===//
+
+// With Uninit = 00, NonZero = 01, Zero = 10 and MaybeZero = 11 the join of
+// two elements is their bitwise or, which lets Memory join 32 variables at a
+// time.
+static_assert(Domain::Uninit == 0 && Domain::NonZero == 1 &&
+                  Domain::Zero == 2 && Domain::MaybeZero == 3,
+              "Memory relies on this encoding of Domain::Element");
+static_assert(Domain::join(Domain::NonZero, Domain::Zero).Value ==
+                      Domain::MaybeZero &&
+                  Domain::join(Domain::Uninit, Domain::Zero).Value ==
+                      Domain::Zero,
+              "Domain::join must be the bitwise or of the encoding");
+
+/**
+ * @brief Abstract state: maps the number of a variable (see ValueNumbering)
+ * to its Domain.
+ *
+ * Domains are packed two bits per variable. Variables that were never set
+ * read as Domain::Uninit, and the memory grows on demand when a variable
+ * past its end is set.
+ */
+class Memory {
+public:
+  /**
+   * @brief Proxy returned by operator[], so that `Mem[N] = D` sets the
+   * domain of variable N.
+   */
+  class Reference {
+  public:
+    Reference(Memory &Mem, unsigned N) : Mem(Mem), N(N) {}
+    operator Domain() const { return Mem.get(N); }
+    Reference &operator=(Domain D) {
+      Mem.set(N, D);
+      return *this;
+    }
+
+  private:
+    Memory &Mem;
+    unsigned N;
+  };
+
+  Memory() = default;
+
+  /**
+   * @brief Memory with the given packed words, as returned by getWords().
+   */
+  explicit Memory(std::vector<uint64_t> Words) : Words(std::move(Words)) {}
+
+  /**
+   * @brief Get the domain of variable N.
+   */
+  Domain get(unsigned N) const {
+    unsigned Word = N / PerWord;
+    if (Word >= Words.size())
+      return Domain(Domain::Uninit);
+    return Domain(static_cast<Domain::Element>(
+        (Words[Word] >> shift(N)) & ElementMask));
+  }
+
+  /**
+   * @brief Set the domain of variable N. Setting ValueNumbering::None, i.e.
+   * a value that is not a variable, is a no-op.
+   */
+  void set(unsigned N, Domain D) {
+    if (N == ValueNumbering::None)
+      return;
+    unsigned Word = N / PerWord;
+    if (Word >= Words.size())
+      Words.resize(Word + 1, 0);
+    Words[Word] = (Words[Word] & ~(ElementMask << shift(N))) |
+                  (static_cast<uint64_t>(D.Value) << shift(N));
+  }
+
+  Reference operator[](unsigned N) { return Reference(*this, N); }
+  Domain operator[](unsigned N) const { return get(N); }
+
+  /**
+   * @brief Join Other into this memory, variable by variable.
+   *
+   * @param Other Memory to join with.
+   * @return true if this memory changed.
+   */
+  bool join(const Memory &Other) {
+    if (Words.size() < Other.Words.size())
+      Words.resize(Other.Words.size(), 0);
+    uint64_t Changed = 0;
+    for (size_t I = 0, E = Other.Words.size(); I < E; ++I) {
+      uint64_t Joined = Words[I] | Other.Words[I];
+      Changed |= Joined ^ Words[I];
+      Words[I] = Joined;
+    }
+    return Changed != 0;
+  }
+
+  /**
+   * @brief Is every variable of this memory at most as large as in Other?
+   */
+  bool leq(const Memory &Other) const {
+    uint64_t Extra = 0;
+    for (size_t I = 0, E = Words.size(); I < E; ++I)
+      Extra |= Words[I] & ~(I < Other.Words.size() ? Other.Words[I] : 0);
+    return Extra == 0;
+  }
+
+  /**
+   * @brief Two memories are equal if every variable has the same domain;
+   * missing variables count as Uninit.
+   */
+  bool operator==(const Memory &Other) const {
+    const std::vector<uint64_t> &Short =
+        Words.size() < Other.Words.size() ? Words : Other.Words;
+    const std::vector<uint64_t> &Long =
+        Words.size() < Other.Words.size() ? Other.Words : Words;
+    uint64_t Diff = 0;
+    for (size_t I = 0, E = Short.size(); I < E; ++I)
+      Diff |= Short[I] ^ Long[I];
+    for (size_t I = Short.size(), E = Long.size(); I < E; ++I)
+      Diff |= Long[I];
+    return Diff == 0;
+  }
+  bool operator!=(const Memory &Other) const { return !(*this == Other); }
+
+  /**
+   * @brief Is every variable Uninit?
+   */
+  bool empty() const {
+    for (uint64_t Word : Words) {
+      if (Word)
+        return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief Number of variables the memory currently has room for; every
+   * variable at or past this number is Uninit.
+   */
+  unsigned size() const { return Words.size() * PerWord; }
+
+  /**
+   * @brief The packed representation, e.g. to store the memory on disk.
+   */
+  const std::vector<uint64_t> &getWords() const { return Words; }
+
+private:
+  static const unsigned PerWord = 32;
+  static const uint64_t ElementMask = 3;
+
+  std::vector<uint64_t> Words;
+
+  static unsigned shift(unsigned N) { return 2 * (N % PerWord); }
+};
+
+/**
+ * @brief Memory has finite height, so it needs no widening or narrowing.
+ */
+template <> struct LatticeTraits<Memory> {
+  static Memory bottom() { return Memory(); }
+  static void join(Memory &Into, const Memory &Other) { Into.join(Other); }
+  static bool leq(const Memory &A, const Memory &B) { return A.leq(B); }
+  static Memory widen(const Memory &Old, const Memory &New) { return New; }
+  static Memory narrow(const Memory &Old, const Memory &New) { return New; }
+};
+
+} // namespace dataflow
+
+#endif // ABSTRACT_MEMORY_H
@@ -0,0 +1,302 @@
+#ifndef MONOTONE_SOLVER_H
+#define MONOTONE_SOLVER_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Function.h"
+
+#include <deque>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace dataflow {
+
+using namespace llvm;
+
+//===----------------------------------------------------------------------===//
+// Lattice Traits
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Operations of the lattice L used by MonotoneSolver. Specialize it
+ * next to the lattice, with:
+ *
+ *   static L bottom();
+ *   static void join(L &Into, const L &Other);   // Into = Into |_| Other
+ *   static bool leq(const L &A, const L &B);      // A [= B
+ *   static L widen(const L &Old, const L &New);   // Old |_| New [= result
+ *   static L narrow(const L &Old, const L &New);  // New [= result [= Old
+ *
+ * widen() and narrow() are applied at the head of every loop; lattices of
+ * finite height can simply return New from both. Operations that need some
+ * context, e.g. widening thresholds, can be given to the solver as a traits
+ * object instead.
+ */
+template <typename L> struct LatticeTraits;
+
+//===----------------------------------------------------------------------===//
+// Directions
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Information flows from the entry block along CFG edges; blocks are
+ * numbered in reverse postorder.
+ */
+struct Forward {
+  static pred_range inputs(BasicBlock *BB) { return predecessors(BB); }
+  static succ_range outputs(BasicBlock *BB) { return successors(BB); }
+  static bool isBoundary(BasicBlock *BB) {
+    return BB == &BB->getParent()->getEntryBlock();
+  }
+  static std::vector<BasicBlock *> order(Function &F) {
+    ReversePostOrderTraversal<Function *> RPOT(&F);
+    return std::vector<BasicBlock *>(RPOT.begin(), RPOT.end());
+  }
+};
+
+/**
+ * @brief Information flows from the exit blocks against CFG edges; blocks
+ * are numbered in postorder.
+ */
+struct Backward {
+  static succ_range inputs(BasicBlock *BB) { return successors(BB); }
+  static pred_range outputs(BasicBlock *BB) { return predecessors(BB); }
+  static bool isBoundary(BasicBlock *BB) {
+    return succ_begin(BB) == succ_end(BB);
+  }
+  static std::vector<BasicBlock *> order(Function &F) {
+    return std::vector<BasicBlock *>(po_begin(&F), po_end(&F));
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// WorkList Policies
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Always returns the pending block with the smallest number, so that
+ * a block is normally evaluated after all of its inputs and each loop is
+ * iterated as a whole.
+ */
+class RPOWorkList {
+public:
+  explicit RPOWorkList(unsigned N) : Queued(N, false) {}
+  bool empty() const { return Pending.empty(); }
+  void push(unsigned I) {
+    if (!Queued[I]) {
+      Queued[I] = true;
+      Pending.push(I);
+    }
+  }
+  unsigned pop() {
+    unsigned I = Pending.top();
+    Pending.pop();
+    Queued[I] = false;
+    return I;
+  }
+
+private:
+  std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>>
+      Pending;
+  std::vector<bool> Queued;
+};
+
+/**
+ * @brief Returns the pending blocks in the order they were pushed.
+ */
+class FIFOWorkList {
+public:
+  explicit FIFOWorkList(unsigned N) : Queued(N, false) {}
+  bool empty() const { return Pending.empty(); }
+  void push(unsigned I) {
+    if (!Queued[I]) {
+      Queued[I] = true;
+      Pending.push_back(I);
+    }
+  }
+  unsigned pop() {
+    unsigned I = Pending.front();
+    Pending.pop_front();
+    Queued[I] = false;
+    return I;
+  }
+
+private:
+  std::deque<unsigned> Pending;
+  std::vector<bool> Queued;
+};
+
+//===----------------------------------------------------------------------===//
+// Monotone Framework Solver
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Worklist solver of a monotone dataflow problem over the basic
+ * blocks of a function.
+ *
+ * Only the state at the input and output of each block is kept. Transfer is
+ * called as `T(BB, State)` and must update State from the input of BB to its
+ * output. Blocks that cannot be reached from the boundary are never
+ * evaluated and have no state.
+ *
+ * @tparam Lattice Abstract state; see LatticeTraits.
+ * @tparam Direction Forward or Backward.
+ * @tparam Transfer Block transfer function.
+ * @tparam WorkList RPOWorkList or FIFOWorkList.
+ * @tparam Traits Lattice operations; see LatticeTraits.
+ */
+template <typename Lattice, typename Direction, typename Transfer,
+          typename WorkList = RPOWorkList,
+          typename Traits = LatticeTraits<Lattice>>
+class MonotoneSolver {
+public:
+  MonotoneSolver(Function &F, Transfer Fn, Traits Ops = Traits())
+      : Blocks(Direction::order(F)), T(std::move(Fn)), Ops(std::move(Ops)),
+        Boundary(this->Ops.bottom()) {
+    for (unsigned I = 0, E = Blocks.size(); I < E; ++I) {
+      Order[Blocks[I]] = I;
+    }
+
+    // By default, a block is a loop head if one of its inputs does not come
+    // before it.
+    IsHead.assign(Blocks.size(), false);
+    for (unsigned I = 0, E = Blocks.size(); I < E; ++I) {
+      for (auto Pred : Direction::inputs(Blocks[I])) {
+        auto It = Order.find(Pred);
+        if (It != Order.end() && It->second >= I)
+          IsHead[I] = true;
+      }
+    }
+  }
+
+  /**
+   * @brief Set the input state of the boundary blocks, e.g. the values of
+   * the arguments at the entry block.
+   */
+  void setBoundary(Lattice B) { Boundary = std::move(B); }
+
+  /**
+   * @brief Widen and narrow at exactly these blocks, e.g. the loop headers
+   * found by LoopInfo, instead of at the targets of back edges.
+   */
+  void setLoopHeads(ArrayRef<BasicBlock *> Heads) {
+    IsHead.assign(Blocks.size(), false);
+    for (BasicBlock *BB : Heads) {
+      auto It = Order.find(BB);
+      if (It != Order.end())
+        IsHead[It->second] = true;
+    }
+  }
+
+  /**
+   * @brief Compute the fixpoint.
+   */
+  void solve() {
+    unsigned N = Blocks.size();
+    In.assign(N, Ops.bottom());
+    Out.assign(N, Ops.bottom());
+
+    WorkList WL(N);
+    for (unsigned I = 0; I < N; ++I) {
+      WL.push(I);
+    }
+
+    while (!WL.empty()) {
+      unsigned I = WL.pop();
+      BasicBlock *BB = Blocks[I];
+
+      Lattice State = input(I);
+      if (IsHead[I])
+        State = Ops.widen(In[I], State);
+      In[I] = State;
+
+      T(BB, State);
+
+      // Merge the new output into the previous one, and revisit the outputs
+      // of BB only if it grew.
+      if (Ops.leq(State, Out[I]))
+        continue;
+      Ops.join(Out[I], State);
+      for (auto Succ : Direction::outputs(BB)) {
+        auto It = Order.find(Succ);
+        if (It != Order.end())
+          WL.push(It->second);
+      }
+    }
+  }
+
+  /**
+   * @brief Refine the fixpoint computed by solve() with at most Rounds
+   * descending passes over all blocks, narrowing at loop heads. Every pass
+   * stays above the least fixpoint, so the result remains sound.
+   */
+  void narrow(unsigned Rounds) {
+    for (unsigned R = 0; R < Rounds; ++R) {
+      bool Changed = false;
+      for (unsigned I = 0, E = Blocks.size(); I < E; ++I) {
+        Lattice State = input(I);
+        if (IsHead[I])
+          State = Ops.narrow(In[I], State);
+        In[I] = State;
+
+        T(Blocks[I], State);
+
+        if (!Ops.leq(Out[I], State))
+          Changed = true;
+        Out[I] = std::move(State);
+      }
+      if (!Changed)
+        return;
+    }
+  }
+
+  /**
+   * @return The state at the input of BB, or nullptr if BB is unreachable.
+   */
+  const Lattice *getIn(BasicBlock *BB) const {
+    auto It = Order.find(BB);
+    return It == Order.end() ? nullptr : &In[It->second];
+  }
+
+  /**
+   * @return The state at the output of BB, or nullptr if BB is unreachable.
+   */
+  const Lattice *getOut(BasicBlock *BB) const {
+    auto It = Order.find(BB);
+    return It == Order.end() ? nullptr : &Out[It->second];
+  }
+
+private:
+  std::vector<BasicBlock *> Blocks;
+  DenseMap<BasicBlock *, unsigned> Order;
+  std::vector<bool> IsHead;
+  Transfer T;
+  Traits Ops;
+  Lattice Boundary;
+  std::vector<Lattice> In;
+  std::vector<Lattice> Out;
+
+  /**
+   * @brief Join of the boundary state and the outputs of the inputs of the
+   * I-th block.
+   */
+  Lattice input(unsigned I) const {
+    BasicBlock *BB = Blocks[I];
+    Lattice State = Ops.bottom();
+    if (Direction::isBoundary(BB))
+      Ops.join(State, Boundary);
+    for (auto Pred : Direction::inputs(BB)) {
+      auto It = Order.find(Pred);
+      if (It != Order.end())
+        Ops.join(State, Out[It->second]);
+    }
+    return State;
+  }
+};
+
+} // namespace dataflow
+
+#endif // MONOTONE_SOLVER_H
@@ -4,6 +4,7 @@
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
 
@@ -12,7 +13,10 @@ namespace instrument {
 struct Instrument : public FunctionPass {
   static char ID;
 
-  Instrument() : FunctionPass(ID) {}
+  // Stream runOnFunction prints its results to.
+  raw_ostream &OS;
+
+  Instrument(raw_ostream &OS = outs()) : FunctionPass(ID), OS(OS) {}
 
   bool runOnFunction(Function &F) override;
 };
@@ -2,6 +2,7 @@
 #define UTILS_H
 
 #include "llvm/IR/Instruction.h"
+#include "llvm/IR/ModuleSlotTracker.h"
 
 using namespace llvm;
 
@@ -26,4 +27,23 @@ const std::string getBinOpName(const char symbol);
  */
 std::string variable(Value *V);
 
+/**
+ * Same as above, but reuses the slot numbering of MST instead of numbering
+ * the whole module again for every call.
+ */
+std::string variable(Value *V, ModuleSlotTracker &MST);
+
+/**
+ * While alive, makes variable(V) on the current thread reuse the slot
+ * numbering of MST, as variable(V, MST) does.
+ */
+class SlotTrackerScope {
+public:
+  explicit SlotTrackerScope(ModuleSlotTracker &MST);
+  ~SlotTrackerScope();
+
+private:
+  ModuleSlotTracker *Saved;
+};
+
 #endif // UTILS_H
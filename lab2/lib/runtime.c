@@ -1,3 +1,10 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -39,21 +46,521 @@ void get_logfile(char *buf, const int buf_size, const char *ext) {
   strncat(buf, ext, strlen(ext));
 }
 
-void __coverage__(int line, int col) {
+/*
+ * Thread-safe logging.
+ *
+ * Every thread formats its records into private buffers, one per log file,
+ * and appends a whole buffer to the log with a single write() on a shared
+ * O_APPEND descriptor when it fills up. Probes therefore never share a lock
+ * or a FILE*. Buffers are flushed when their thread exits, at exit(), and on
+ * fatal signals so that records of crashing runs are kept.
+ *
+ * A probe holds the busy flag of its own thread while it touches the
+ * thread's buffers and profiles. exit() and the signal handler take the
+ * flag of every thread that is still running before reading its state, so
+ * they never see a record or a profile half written.
+ */
+
+#define LOG_BUFFER_SIZE 4096
+#define LOG_RECORD_MAX_SIZE 256
+
+enum log_kind { COVERAGE_LOG, BINOPS_LOG, NUM_LOGS };
+
+static const char *log_exts[NUM_LOGS] = {".cov", ".binops"};
+static atomic_int log_fds[NUM_LOGS] = {-1, -1};
+
+struct log_buffer {
+  size_t len;
+  char data[LOG_BUFFER_SIZE];
+};
+
+struct binop_profile;
+
+struct thread_state {
+  // Set while a probe, finish_runtime() or flush_on_signal() uses the state.
+  atomic_flag busy;
+  struct log_buffer logs[NUM_LOGS];
+  // Per-thread binop profiles indexed by site ID, merged when the thread
+  // exits or at exit(). Grown when a module registers more sites.
+  struct binop_profile **profiles;
+  int num_profiles;
+  struct thread_state *prev;
+  struct thread_state *next;
+};
+
+static pthread_once_t runtime_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_state_key;
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct thread_state *threads = NULL;
+static _Thread_local struct thread_state *self = NULL;
+
+static int get_log_fd(enum log_kind kind) {
+  int fd = atomic_load(&log_fds[kind]);
+  if (fd >= 0)
+    return fd;
   char logfile[STR_MAX_SIZE];
-  get_logfile(logfile, sizeof(logfile), ".cov");
-  FILE *f = fopen(logfile, "a");
-  fprintf(f, "%d, %d\n", line, col);
-  fclose(f);
+  get_logfile(logfile, sizeof(logfile), log_exts[kind]);
+  int opened = open(logfile, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (opened == -1) {
+    fprintf(stderr, "Error: Cannot open %s\n", logfile);
+    exit(1);
+  }
+  int expected = -1;
+  if (!atomic_compare_exchange_strong(&log_fds[kind], &expected, opened)) {
+    close(opened);
+    return expected;
+  }
+  return opened;
+}
+
+// Only uses async-signal-safe calls once the log file is open.
+static void flush_log(struct log_buffer *buf, enum log_kind kind) {
+  size_t off = 0;
+  if (!buf->len)
+    return;
+  int fd = get_log_fd(kind);
+  while (off < buf->len) {
+    ssize_t n = write(fd, buf->data + off, buf->len - off);
+    if (n <= 0)
+      break;
+    off += n;
+  }
+  buf->len = 0;
+}
+
+static void flush_logs(struct thread_state *ts) {
+  for (int kind = 0; kind < NUM_LOGS; ++kind)
+    flush_log(&ts->logs[kind], kind);
+}
+
+static void lock_thread_state(struct thread_state *ts) {
+  while (atomic_flag_test_and_set_explicit(&ts->busy, memory_order_acquire))
+    sched_yield();
+}
+
+static void unlock_thread_state(struct thread_state *ts) {
+  atomic_flag_clear_explicit(&ts->busy, memory_order_release);
+}
+
+static void merge_profiles(struct thread_state *ts, int take);
+
+// Runs in the exiting thread, so no probe can use ts any more.
+static void release_thread_state(void *arg) {
+  struct thread_state *ts = arg;
+  pthread_mutex_lock(&threads_lock);
+  flush_logs(ts);
+  merge_profiles(ts, 1);
+  if (ts->prev)
+    ts->prev->next = ts->next;
+  else
+    threads = ts->next;
+  if (ts->next)
+    ts->next->prev = ts->prev;
+  pthread_mutex_unlock(&threads_lock);
+  free(ts->profiles);
+  free(ts);
+}
+
+static void dump_binop_profiles(void);
+
+/*
+ * The threads left in the list are still running and may keep using their
+ * state after exit() returns here, so their profiles are copied rather than
+ * taken and freed.
+ */
+static void finish_runtime(void) {
+  pthread_mutex_lock(&threads_lock);
+  for (struct thread_state *ts = threads; ts; ts = ts->next) {
+    lock_thread_state(ts);
+    flush_logs(ts);
+    merge_profiles(ts, 0);
+    unlock_thread_state(ts);
+  }
+  pthread_mutex_unlock(&threads_lock);
+  dump_binop_profiles();
+}
+
+static const int fatal_signals[] = {SIGSEGV, SIGFPE, SIGBUS, SIGILL, SIGABRT};
+#define NUM_FATAL_SIGNALS (sizeof(fatal_signals) / sizeof(fatal_signals[0]))
+static struct sigaction old_actions[NUM_FATAL_SIGNALS];
+
+/*
+ * The crashing thread may hold threads_lock, so walk the list without it,
+ * and skip the threads caught in the middle of a probe, the crashing one
+ * included, rather than wait for them.
+ */
+static void flush_on_signal(int sig) {
+  for (struct thread_state *ts = threads; ts; ts = ts->next) {
+    if (atomic_flag_test_and_set_explicit(&ts->busy, memory_order_acquire))
+      continue;
+    for (int kind = 0; kind < NUM_LOGS; ++kind)
+      if (atomic_load(&log_fds[kind]) >= 0)
+        flush_log(&ts->logs[kind], kind);
+    unlock_thread_state(ts);
+  }
+  for (size_t i = 0; i < NUM_FATAL_SIGNALS; ++i)
+    if (fatal_signals[i] == sig)
+      sigaction(sig, &old_actions[i], NULL);
+  raise(sig);
+}
+
+static void init_runtime(void) {
+  pthread_key_create(&thread_state_key, release_thread_state);
+  atexit(finish_runtime);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = flush_on_signal;
+  sigemptyset(&action.sa_mask);
+  for (size_t i = 0; i < NUM_FATAL_SIGNALS; ++i)
+    sigaction(fatal_signals[i], &action, &old_actions[i]);
+}
+
+static struct thread_state *get_thread_state(void) {
+  if (self)
+    return self;
+  pthread_once(&runtime_once, init_runtime);
+  self = calloc(1, sizeof(*self));
+  if (!self) {
+    fprintf(stderr, "Error: Cannot allocate thread state\n");
+    exit(1);
+  }
+  pthread_mutex_lock(&threads_lock);
+  self->next = threads;
+  if (threads)
+    threads->prev = self;
+  threads = self;
+  pthread_mutex_unlock(&threads_lock);
+  // The main thread does not run key destructors; finish_runtime covers it.
+  pthread_setspecific(thread_state_key, self);
+  return self;
+}
+
+static void log_record(enum log_kind kind, const char *fmt, ...)
+    __attribute__((format(printf, 2, 3)));
+
+static void log_record(enum log_kind kind, const char *fmt, ...) {
+  struct thread_state *ts = get_thread_state();
+  struct log_buffer *buf = &ts->logs[kind];
+  // Open the log before buffering so the signal handler never has to, and
+  // before taking the flag, since it exits if the file cannot be opened.
+  get_log_fd(kind);
+  lock_thread_state(ts);
+  if (buf->len + LOG_RECORD_MAX_SIZE > LOG_BUFFER_SIZE)
+    flush_log(buf, kind);
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf->data + buf->len, LOG_RECORD_MAX_SIZE, fmt, args);
+  va_end(args);
+  if (n > 0)
+    buf->len += n < LOG_RECORD_MAX_SIZE ? n : LOG_RECORD_MAX_SIZE - 1;
+  unlock_thread_state(ts);
+}
+
+void __coverage__(int line, int col) {
+  log_record(COVERAGE_LOG, "%d, %d\n", line, col);
 }
 
 void __binop_op__(char c, int line, int col, int op1, int op2) {
-  char logfile[STR_MAX_SIZE];
-  get_logfile(logfile, sizeof(logfile), ".binops");
-  FILE *f = fopen(logfile, "a");
-  fprintf(
-      f,
+  log_record(
+      BINOPS_LOG,
       "%s on Line %d, Column %d with first operand=%d and second operand=%d\n",
       getBinOpName(c), line, col, op1, op2);
+}
+
+/*
+ * Site table emitted by DynamicAnalysisPass with `-site-table` or
+ * `-binop-aggregate`. Probes pass only a site ID.
+ *
+ * Every instrumented module numbers its sites from 0 and registers its table
+ * from a constructor. The runtime gives each table a base, which the module
+ * adds to its own IDs, so the sites of all modules share one ID space.
+ */
+struct site {
+  const char *file;
+  const char *function;
+  int line;
+  int col;
+  char symbol;
+};
+
+// Every registered site by ID. A module loaded with dlopen() registers while
+// other threads may run probes, so the grown array is published atomically
+// and the previous one is never freed.
+static _Atomic(const struct site **) sites = NULL;
+static atomic_int num_sites = 0;
+
+void __dynamic_sites_register__(const struct site *table, int count,
+                                int *base) {
+  pthread_mutex_lock(&threads_lock);
+  int old = atomic_load(&num_sites);
+  const struct site **grown = malloc((old + count) * sizeof(*grown));
+  if (!grown) {
+    fprintf(stderr, "Error: Cannot allocate site table\n");
+    exit(1);
+  }
+  if (old)
+    memcpy(grown, atomic_load(&sites), old * sizeof(*grown));
+  for (int i = 0; i < count; ++i)
+    grown[old + i] = &table[i];
+  *base = old;
+  atomic_store(&sites, grown);
+  atomic_store(&num_sites, old + count);
+  pthread_mutex_unlock(&threads_lock);
+}
+
+static const struct site *get_site(int site) {
+  return atomic_load(&sites)[site];
+}
+
+void __coverage_site__(int site) {
+  const struct site *s = get_site(site);
+  __coverage__(s->line, s->col);
+}
+
+void __binop_site__(int site, int op1, int op2) {
+  const struct site *s = get_site(site);
+  __binop_op__(s->symbol, s->line, s->col, op1, op2);
+}
+
+/*
+ * Per-site operand profiles used by `-binop-aggregate`.
+ *
+ * Every site owns a fixed-size record, so the profile grows with the number
+ * of instrumented operators rather than with the number of executions.
+ */
+
+// Number of smallest hashes kept by the distinct-value sketch.
+#define SKETCH_SIZE 16
+
+// Buckets of the operand histogram: one for zero and one per bit length for
+// each sign. Positive values have at most 31 bits, so the last bucket is
+// HIST_ZERO + 31; INT_MIN has 32 and takes bucket 0.
+#define HIST_BUCKETS 64
+#define HIST_ZERO 32
+
+struct operand_profile {
+  int min;
+  int max;
+  unsigned long zeros;
+  // Smallest distinct hashes seen so far, sorted in increasing order.
+  uint32_t sketch[SKETCH_SIZE];
+  int sketch_len;
+  unsigned long hist[HIST_BUCKETS];
+};
+
+struct binop_profile {
+  unsigned long count;
+  struct operand_profile operands[2];
+};
+
+// Profiles of exited threads indexed by site ID, plus those of the running
+// ones once exit() is called, guarded by threads_lock.
+static struct binop_profile **merged_profiles = NULL;
+static int num_merged = 0;
+
+/*
+ * Grow *profiles from *count to num_sites entries, the new ones empty.
+ * Returns 0 if the memory cannot be allocated.
+ */
+static int grow_profiles(struct binop_profile ***profiles, int *count) {
+  int wanted = atomic_load(&num_sites);
+  if (*count >= wanted)
+    return 1;
+  struct binop_profile **grown = realloc(*profiles, wanted * sizeof(*grown));
+  if (!grown)
+    return 0;
+  memset(grown + *count, 0, (wanted - *count) * sizeof(*grown));
+  *profiles = grown;
+  *count = wanted;
+  return 1;
+}
+static uint32_t hash_operand(int value) {
+  uint32_t h = (uint32_t)value;
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+static int bit_length(uint32_t value) {
+  int len = 0;
+  while (value) {
+    ++len;
+    value >>= 1;
+  }
+  return len;
+}
+
+static int hist_bucket(int value) {
+  if (value == 0)
+    return HIST_ZERO;
+  if (value > 0)
+    return HIST_ZERO + bit_length((uint32_t)value);
+  return HIST_ZERO - bit_length(-(uint32_t)value);
+}
+
+static void sketch_insert(struct operand_profile *p, uint32_t h) {
+  int pos = p->sketch_len;
+  while (pos > 0 && p->sketch[pos - 1] > h)
+    --pos;
+  if (pos > 0 && p->sketch[pos - 1] == h)
+    return;
+  if (pos == SKETCH_SIZE)
+    return;
+  int last = p->sketch_len < SKETCH_SIZE ? p->sketch_len : SKETCH_SIZE - 1;
+  memmove(&p->sketch[pos + 1], &p->sketch[pos],
+          (last - pos) * sizeof(p->sketch[0]));
+  p->sketch[pos] = h;
+  if (p->sketch_len < SKETCH_SIZE)
+    ++p->sketch_len;
+}
+
+/*
+ * Exact below SKETCH_SIZE distinct values, otherwise the usual
+ * k-minimum-values estimate (k - 1) / (k-th smallest hash / 2^32).
+ */
+static unsigned long sketch_estimate(const struct operand_profile *p) {
+  if (p->sketch_len < SKETCH_SIZE)
+    return p->sketch_len;
+  double kth = (double)p->sketch[SKETCH_SIZE - 1] + 1.0;
+  return (unsigned long)((SKETCH_SIZE - 1) * 4294967296.0 / kth);
+}
+
+static void profile_operand(struct operand_profile *p, int value,
+                            unsigned long count) {
+  if (count == 1 || value < p->min)
+    p->min = value;
+  if (count == 1 || value > p->max)
+    p->max = value;
+  if (value == 0)
+    ++p->zeros;
+  sketch_insert(p, hash_operand(value));
+  ++p->hist[hist_bucket(value)];
+}
+
+static void print_hist_range(FILE *f, int bucket) {
+  if (bucket == HIST_ZERO) {
+    fprintf(f, "0");
+  } else if (bucket > HIST_ZERO) {
+    int len = bucket - HIST_ZERO;
+    fprintf(f, "%ld..%ld", 1L << (len - 1), (1L << len) - 1);
+  } else {
+    int len = HIST_ZERO - bucket;
+    fprintf(f, "%ld..%ld", -((1L << len) - 1), -(1L << (len - 1)));
+  }
+}
+
+static void dump_operand(FILE *f, const char *name,
+                         const struct operand_profile *p) {
+  fprintf(f, "  %s operand: min=%d max=%d zeros=%lu distinct~%lu histogram:",
+          name, p->min, p->max, p->zeros, sketch_estimate(p));
+  for (int b = 0; b < HIST_BUCKETS; ++b) {
+    if (!p->hist[b])
+      continue;
+    fprintf(f, " [");
+    print_hist_range(f, b);
+    fprintf(f, "]=%lu", p->hist[b]);
+  }
+  fprintf(f, "\n");
+}
+
+static void merge_operand(struct operand_profile *dst,
+                          const struct operand_profile *src,
+                          unsigned long dst_count) {
+  if (!dst_count || src->min < dst->min)
+    dst->min = src->min;
+  if (!dst_count || src->max > dst->max)
+    dst->max = src->max;
+  dst->zeros += src->zeros;
+  for (int i = 0; i < src->sketch_len; ++i)
+    sketch_insert(dst, src->sketch[i]);
+  for (int b = 0; b < HIST_BUCKETS; ++b)
+    dst->hist[b] += src->hist[b];
+}
+
+/*
+ * Merge the profiles of ts into merged_profiles. If take is set, they are
+ * moved or freed, otherwise they are left to their thread untouched.
+ * Must be called with threads_lock held.
+ */
+static void merge_profiles(struct thread_state *ts, int take) {
+  if (!ts->profiles)
+    return;
+  if (!grow_profiles(&merged_profiles, &num_merged))
+    return;
+  for (int i = 0; i < ts->num_profiles; ++i) {
+    struct binop_profile *src = ts->profiles[i];
+    if (!src)
+      continue;
+    struct binop_profile *dst = merged_profiles[i];
+    if (!dst && take) {
+      merged_profiles[i] = src;
+      ts->profiles[i] = NULL;
+      continue;
+    }
+    if (!dst) {
+      dst = merged_profiles[i] = calloc(1, sizeof(*dst));
+      if (!dst)
+        continue;
+    }
+    merge_operand(&dst->operands[0], &src->operands[0], dst->count);
+    merge_operand(&dst->operands[1], &src->operands[1], dst->count);
+    dst->count += src->count;
+    if (take) {
+      free(src);
+      ts->profiles[i] = NULL;
+    }
+  }
+}
+
+static void dump_binop_profiles(void) {
+  if (!merged_profiles)
+    return;
+  char logfile[STR_MAX_SIZE];
+  get_logfile(logfile, sizeof(logfile), ".binprof");
+  FILE *f = fopen(logfile, "w");
+  if (!f)
+    return;
+  for (int i = 0; i < num_merged; ++i) {
+    const struct binop_profile *p = merged_profiles[i];
+    if (!p)
+      continue;
+    const struct site *s = get_site(i);
+    fprintf(f, "%s on Line %d, Column %d executed %lu times\n",
+            getBinOpName(s->symbol), s->line, s->col, p->count);
+    dump_operand(f, "first", &p->operands[0]);
+    dump_operand(f, "second", &p->operands[1]);
+  }
   fclose(f);
 }
+
+// Must be called with the busy flag of ts set. Returns NULL if the memory
+// cannot be allocated.
+static struct binop_profile *get_binop_profile(struct thread_state *ts,
+                                               int site) {
+  if (site >= ts->num_profiles &&
+      !grow_profiles(&ts->profiles, &ts->num_profiles))
+    return NULL;
+  if (!ts->profiles[site])
+    ts->profiles[site] = calloc(1, sizeof(struct binop_profile));
+  return ts->profiles[site];
+}
+
+void __binop_profile__(int site, int op1, int op2) {
+  struct thread_state *ts = get_thread_state();
+  lock_thread_state(ts);
+  struct binop_profile *p = get_binop_profile(ts, site);
+  if (!p) {
+    // exit() takes the flag of every running thread.
+    unlock_thread_state(ts);
+    fprintf(stderr, "Error: Cannot allocate binop profile\n");
+    exit(1);
+  }
+  ++p->count;
+  profile_operand(&p->operands[0], op1, p->count);
+  profile_operand(&p->operands[1], op2, p->count);
+  unlock_thread_state(ts);
+}
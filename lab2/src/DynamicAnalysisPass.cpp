@@ -1,6 +1,7 @@
 #include "Instrument.h"
 #include "Utils.h"
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/IR/DebugInfoMetadata.h"
@@ -14,7 +15,9 @@
 #include "llvm/Passes/OptimizationLevel.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
 
 #include <vector>
 
@@ -27,10 +30,39 @@ const auto PASS_DESC = "Dynamic Analysis Pass";
 
 const auto COVERAGE_FUNCTION_NAME = "__coverage__";
 const auto BINOP_OPERANDS_FUNCTION_NAME = "__binop_op__";
+const auto COVERAGE_SITE_FUNCTION_NAME = "__coverage_site__";
+const auto BINOP_SITE_FUNCTION_NAME = "__binop_site__";
+const auto BINOP_PROFILE_FUNCTION_NAME = "__binop_profile__";
+const auto SITES_REGISTER_FUNCTION_NAME = "__dynamic_sites_register__";
+
+// Named metadata collecting one descriptor per site until the table is built.
+const auto SITES_METADATA_NAME = "dynamic.sites";
+// Section holding the per-module site table.
+const auto SITES_SECTION_NAME = "dynamic_sites";
+// Per-module global the runtime sets to the ID of the module's first site.
+const auto SITES_BASE_NAME = "__dynamic_sites_base";
+
+static cl::opt<bool> UseSiteTable(
+    "site-table",
+    cl::desc("Emit a per-module site table and pass only a site ID to the "
+             "runtime at every probe"),
+    cl::init(false));
+
+static cl::opt<bool> AggregateBinOps(
+    "binop-aggregate",
+    cl::desc("Aggregate binary operator operands per site in the runtime "
+             "instead of logging every execution (implies -site-table)"),
+    cl::init(false));
 
 void instrumentCoverage(Module *M, Instruction &I, int Line, int Col);
 void instrumentBinOpOperands(Module *M, BinaryOperator *BinOp, int Line,
                              int Col);
+unsigned allocateSite(Module *M, Instruction &I, const DebugLoc &Loc);
+GlobalVariable *getSiteBase(Module *M);
+Value *loadSiteBase(Module *M, Function *F);
+Value *createSiteID(IRBuilder<> &Builder, Module *M, unsigned SiteID);
+void instrumentCoverageSite(Module *M, Instruction &I, unsigned SiteID);
+void instrumentBinOpSite(Module *M, BinaryOperator *BinOp, unsigned SiteID);
 
 /**
  * @brief Instruments given function for dynamic analysis.
@@ -59,6 +91,18 @@ bool Instrument::runOnFunction(Function &F) {
                         {Int8Type, Int32Type, Int32Type, Int32Type, Int32Type},
                         /*isVarArg=*/false));
 
+  bool SiteMode = UseSiteTable || AggregateBinOps;
+  if (SiteMode) {
+    (void)M->getOrInsertFunction(
+        COVERAGE_SITE_FUNCTION_NAME,
+        FunctionType::get(VoidType, {Int32Type}, /*isVarArg=*/false));
+    (void)M->getOrInsertFunction(
+        AggregateBinOps ? BINOP_PROFILE_FUNCTION_NAME
+                        : BINOP_SITE_FUNCTION_NAME,
+        FunctionType::get(VoidType, {Int32Type, Int32Type, Int32Type},
+                          /*isVarArg=*/false));
+  }
+
   for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
     Instruction &Inst = (*Iter);
     llvm::DebugLoc DebugLoc = Inst.getDebugLoc();
@@ -70,7 +114,10 @@ bool Instrument::runOnFunction(Function &F) {
 
     int Line = DebugLoc.getLine();
     int Col = DebugLoc.getCol();
-    instrumentCoverage(M, Inst, Line, Col);
+    if (SiteMode)
+      instrumentCoverageSite(M, Inst, allocateSite(M, Inst, DebugLoc));
+    else
+      instrumentCoverage(M, Inst, Line, Col);
 
     /**
      * TODO: Add code to check if instruction is a BinaryOperator and if so,
@@ -106,6 +153,9 @@ void instrumentCoverage(Module *M, Instruction &I, int Line, int Col) {
 /**
  * @brief Instruments given binary operator for its operands.
  *
+ * With `-site-table` or `-binop-aggregate`, the binary operator gets a site
+ * ID here and is instrumented by instrumentBinOpSite instead.
+ *
  * @param M LLVM module.
  * @param BinOp Binary operator to be instrumented.
  * @param Line Line of binary operators.
@@ -117,6 +167,12 @@ void instrumentBinOpOperands(Module *M, BinaryOperator *BinOp, int Line,
   auto *Int32Type = Type::getInt32Ty(Context);
   auto *CharType = Type::getInt8Ty(Context);
 
+  if (UseSiteTable || AggregateBinOps) {
+    instrumentBinOpSite(M, BinOp,
+                        allocateSite(M, *BinOp, BinOp->getDebugLoc()));
+    return;
+  }
+
   /**
    * TODO: Add code to instrument the BinaryOperator to print
    * its location, operation type and the runtime values of its
@@ -124,14 +180,249 @@ void instrumentBinOpOperands(Module *M, BinaryOperator *BinOp, int Line,
    */
 }
 
+/**
+ * @brief Allocates the next site ID of a module.
+ *
+ * Site IDs are dense and start at 0. The descriptor of every site is kept in
+ * module metadata until emitSiteTable turns it into a constant table, which
+ * keeps IDs unique across the functions of a module. Probes add the base the
+ * runtime gives the module, see createSiteID.
+ *
+ * @param M LLVM module.
+ * @param I Instruction at site.
+ * @param Loc Debug location of instruction.
+ * @return ID of the new site.
+ */
+unsigned allocateSite(Module *M, Instruction &I, const DebugLoc &Loc) {
+  auto &Context = M->getContext();
+  auto *Int32Type = Type::getInt32Ty(Context);
+  auto *CharType = Type::getInt8Ty(Context);
+
+  char Symbol = 0;
+  if (auto *BinOp = dyn_cast<BinaryOperator>(&I))
+    Symbol = getBinOpSymbol(BinOp->getOpcode());
+
+  StringRef File = Loc->getFilename();
+
+  NamedMDNode *Sites = M->getOrInsertNamedMetadata(SITES_METADATA_NAME);
+  unsigned SiteID = Sites->getNumOperands();
+  Sites->addOperand(MDTuple::get(
+      Context,
+      {MDString::get(Context, File),
+       MDString::get(Context, I.getFunction()->getName()),
+       ConstantAsMetadata::get(ConstantInt::get(Int32Type, Loc.getLine())),
+       ConstantAsMetadata::get(ConstantInt::get(Int32Type, Loc.getCol())),
+       ConstantAsMetadata::get(ConstantInt::get(CharType, Symbol))}));
+  return SiteID;
+}
+
+/**
+ * @brief Returns the global holding the base of the module's site IDs.
+ *
+ * The constructor emitted by emitSiteTable has the runtime set it, so that
+ * the sites of every instrumented module of a program get distinct IDs.
+ *
+ * @param M LLVM module.
+ */
+GlobalVariable *getSiteBase(Module *M) {
+  if (auto *Base = M->getNamedGlobal(SITES_BASE_NAME))
+    return Base;
+  auto *Int32Type = Type::getInt32Ty(M->getContext());
+  return new GlobalVariable(*M, Int32Type, /*isConstant=*/false,
+                            GlobalValue::InternalLinkage,
+                            ConstantInt::get(Int32Type, 0), SITES_BASE_NAME);
+}
+
+/**
+ * @brief Returns the base of the module's site IDs, loaded once at the start
+ * of the entry block of F and shared by every probe of F.
+ *
+ * The base is set by a module constructor and never changes afterwards.
+ *
+ * @param M LLVM module.
+ * @param F Function being instrumented.
+ */
+Value *loadSiteBase(Module *M, Function *F) {
+  GlobalVariable *Base = getSiteBase(M);
+  BasicBlock &Entry = F->getEntryBlock();
+  if (auto *Load = dyn_cast<LoadInst>(&Entry.front()))
+    if (Load->getPointerOperand() == Base)
+      return Load;
+  IRBuilder<> Builder(&Entry, Entry.begin());
+  return Builder.CreateLoad(Base->getValueType(), Base, "site.base");
+}
+
+/**
+ * @brief Emits the program-wide ID of a site: its ID in the module plus the
+ * base of the module.
+ *
+ * @param Builder Builder positioned at the probe.
+ * @param M LLVM module.
+ * @param SiteID Site in the module.
+ */
+Value *createSiteID(IRBuilder<> &Builder, Module *M, unsigned SiteID) {
+  Value *Base = loadSiteBase(M, Builder.GetInsertBlock()->getParent());
+  return Builder.CreateAdd(Base, Builder.getInt32(SiteID));
+}
+
+/**
+ * @brief Instruments given instruction for coverage by site ID.
+ *
+ * @param M LLVM module.
+ * @param I Instruction to be instrumented.
+ * @param SiteID Site of instruction.
+ */
+void instrumentCoverageSite(Module *M, Instruction &I, unsigned SiteID) {
+  IRBuilder<> Builder(&I);
+  std::vector<Value *> Args = {createSiteID(Builder, M, SiteID)};
+
+  auto *CoverageFunction = M->getFunction(COVERAGE_SITE_FUNCTION_NAME);
+  Builder.CreateCall(CoverageFunction, Args);
+}
+
+/**
+ * @brief Instruments given binary operator for its operands by site ID.
+ *
+ * Location and operator of the site are looked up by the runtime, so the
+ * probe only carries the site ID and the operand values. With
+ * `-binop-aggregate` the operands are folded into a per-site profile instead
+ * of being logged. Only integer operators are instrumented; operands are
+ * sign-extended or truncated to 32 bits.
+ *
+ * @param M LLVM module.
+ * @param BinOp Binary operator to be instrumented.
+ * @param SiteID Site of binary operator.
+ */
+void instrumentBinOpSite(Module *M, BinaryOperator *BinOp, unsigned SiteID) {
+  if (!BinOp->getType()->isIntegerTy())
+    return;
+
+  auto *Int32Type = Type::getInt32Ty(M->getContext());
+
+  IRBuilder<> Builder(BinOp);
+  Value *Op1 = Builder.CreateSExtOrTrunc(BinOp->getOperand(0), Int32Type);
+  Value *Op2 = Builder.CreateSExtOrTrunc(BinOp->getOperand(1), Int32Type);
+
+  std::vector<Value *> Args = {createSiteID(Builder, M, SiteID), Op1, Op2};
+
+  auto *BinOpFunction = M->getFunction(
+      AggregateBinOps ? BINOP_PROFILE_FUNCTION_NAME : BINOP_SITE_FUNCTION_NAME);
+  Builder.CreateCall(BinOpFunction, Args);
+}
+
+/**
+ * @brief Returns a pointer to a private constant C string.
+ *
+ * @param M LLVM module.
+ * @param Str Contents of string.
+ * @param Strings Strings already emitted for M, reused for equal contents.
+ * @return Constant pointer to string.
+ */
+Constant *getStringConstant(Module &M, StringRef Str,
+                            StringMap<Constant *> &Strings) {
+  auto It = Strings.find(Str);
+  if (It != Strings.end())
+    return It->second;
+
+  auto &Context = M.getContext();
+  auto *Init = ConstantDataArray::getString(Context, Str);
+  auto *String =
+      new GlobalVariable(M, Init->getType(), /*isConstant=*/true,
+                         GlobalValue::PrivateLinkage, Init, ".site.str");
+  String->setUnnamedAddr(GlobalValue::UnnamedAddr::Global);
+  String->setAlignment(Align(1));
+
+  auto *Ptr =
+      ConstantExpr::getPointerCast(String, PointerType::getUnqual(Context));
+  Strings[Str] = Ptr;
+  return Ptr;
+}
+
+/**
+ * @brief Turns the site descriptors of a module into a constant table.
+ *
+ * The table is an array of
+ *
+ *   struct site { const char *file; const char *function;
+ *                 int line; int col; char symbol; };
+ *
+ * indexed by site ID and placed in its own section, so offline tools can
+ * find it in the binary as well. A module constructor hands the table to
+ * the runtime through `__dynamic_sites_register__`, which sets the base of
+ * the module's site IDs.
+ *
+ * @param M LLVM module.
+ */
+void emitSiteTable(Module &M) {
+  NamedMDNode *Sites = M.getNamedMetadata(SITES_METADATA_NAME);
+  if (!Sites)
+    return;
+
+  auto &Context = M.getContext();
+  auto *VoidType = Type::getVoidTy(Context);
+  auto *Int32Type = Type::getInt32Ty(Context);
+  auto *CharType = Type::getInt8Ty(Context);
+  auto *PtrType = PointerType::getUnqual(Context);
+  auto *SiteType = StructType::create(
+      Context, {PtrType, PtrType, Int32Type, Int32Type, CharType}, "site");
+
+  StringMap<Constant *> Strings;
+  std::vector<Constant *> Entries;
+  for (MDNode *Site : Sites->operands()) {
+    auto Field = [&](unsigned Idx) {
+      return cast<ConstantAsMetadata>(Site->getOperand(Idx))->getValue();
+    };
+    Entries.push_back(ConstantStruct::get(
+        SiteType,
+        {getStringConstant(
+             M, cast<MDString>(Site->getOperand(0))->getString(), Strings),
+         getStringConstant(
+             M, cast<MDString>(Site->getOperand(1))->getString(), Strings),
+         Field(2), Field(3), Field(4)}));
+  }
+
+  auto *TableType = ArrayType::get(SiteType, Entries.size());
+  auto *Table = new GlobalVariable(M, TableType, /*isConstant=*/true,
+                                   GlobalValue::InternalLinkage,
+                                   ConstantArray::get(TableType, Entries),
+                                   "__dynamic_sites");
+  Table->setSection(SITES_SECTION_NAME);
+
+  auto Register = M.getOrInsertFunction(
+      SITES_REGISTER_FUNCTION_NAME,
+      FunctionType::get(VoidType, {PtrType, Int32Type, PtrType},
+                        /*isVarArg=*/false));
+
+  auto *Ctor = Function::Create(FunctionType::get(VoidType, false),
+                                GlobalValue::InternalLinkage,
+                                "__dynamic_sites_ctor", &M);
+  IRBuilder<> Builder(BasicBlock::Create(Context, "", Ctor));
+  Builder.CreateCall(Register,
+                     {ConstantExpr::getPointerCast(Table, PtrType),
+                      ConstantInt::get(Int32Type, Entries.size()),
+                      ConstantExpr::getPointerCast(getSiteBase(&M), PtrType)});
+  Builder.CreateRetVoid();
+  appendToGlobalCtors(M, Ctor, /*Priority=*/0);
+
+  Sites->eraseFromParent();
+}
+
 char Instrument::ID = 1;
 static RegisterPass<Instrument> X(PASS_NAME, PASS_NAME, false, false);
 
 
+// Runs on the whole module so that the site table can be emitted once after
+// every function has been instrumented.
 struct DynamicAnalysisNPMWrapper : public PassInfoMixin<DynamicAnalysisNPMWrapper> {
-  PreservedAnalyses run(Function &F, FunctionAnalysisManager &) {
-    Instrument P;
-    bool Modified = P.runOnFunction(F);
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &) {
+    bool Modified = false;
+    for (Function &F : M) {
+      if (F.isDeclaration())
+        continue;
+      Instrument P;
+      Modified |= P.runOnFunction(F);
+    }
+    emitSiteTable(M);
     return Modified ? PreservedAnalyses::none() : PreservedAnalyses::all();
   }
 };
@@ -143,18 +434,17 @@ extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
       "0.1",
       [](PassBuilder &PB) {
         PB.registerPipelineParsingCallback(
-            [](StringRef Name, FunctionPassManager &FPM,
+            [](StringRef Name, ModulePassManager &MPM,
                ArrayRef<PassBuilder::PipelineElement>) {
               if (Name == "dynamic-analysis" || Name == PASS_NAME) {
-                FPM.addPass(DynamicAnalysisNPMWrapper());
+                MPM.addPass(DynamicAnalysisNPMWrapper());
                 return true;
               }
               return false;
             });
         PB.registerPipelineStartEPCallback(
             [](ModulePassManager &MPM, OptimizationLevel) {
-              MPM.addPass(
-                  createModuleToFunctionPassAdaptor(DynamicAnalysisNPMWrapper()));
+              MPM.addPass(DynamicAnalysisNPMWrapper());
             });
       }};
 }
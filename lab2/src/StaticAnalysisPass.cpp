@@ -1,18 +1,32 @@
 #include "Instrument.h"
 #include "Utils.h"
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/IR/ModuleSlotTracker.h"
 #include "llvm/IR/PassManager.h"
 #include "llvm/Passes/OptimizationLevel.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <tuple>
+#include <vector>
+
 using namespace llvm;
 
 namespace instrument {
@@ -20,10 +34,175 @@ namespace instrument {
 const auto PASS_NAME = "StaticAnalysisPass";
 const auto PASS_DESC = "Static Analysis Pass";
 
+static cl::opt<std::string> ReportPath(
+    "static-report",
+    cl::desc("Write the module-level static report to this file ('-' for "
+             "stdout)"),
+    cl::init("-"));
+
+enum class ReportFormat { JSON, CSV };
+
+static cl::opt<ReportFormat> ReportKind(
+    "static-report-format", cl::desc("Format of the module-level report"),
+    cl::values(clEnumValN(ReportFormat::JSON, "json", "One JSON document"),
+               clEnumValN(ReportFormat::CSV, "csv", "One row per location")),
+    cl::init(ReportFormat::JSON));
+
+static cl::opt<unsigned> ReportThreads(
+    "static-threads",
+    cl::desc("Number of threads used by the module-level driver (0 = all "
+             "hardware threads)"),
+    cl::init(0));
+
+/**
+ * Everything runOnFunction prints for one function. Records are kept in
+ * instruction order so that the report is independent of scheduling.
+ */
+struct BinOpRecord {
+  size_t Location; // Index into FunctionRecord::Locations.
+  int Line;
+  int Col;
+  std::string Op;
+  std::string FirstOperand;
+  std::string SecondOperand;
+};
+
+struct FunctionRecord {
+  std::string Name;
+  std::vector<std::pair<int, int>> Locations;
+  std::vector<BinOpRecord> BinOps;
+};
+
+/**
+ * Parse one line of runOnFunction, either "<Line>, <Col>" or "<Operator> on
+ * Line <Line>, Column <Col> with first operand <OP1> and second operand
+ * <OP2>", into Record. Other lines are ignored.
+ */
+static void parseLine(StringRef Text, FunctionRecord &Record) {
+  int Line, Col;
+  StringRef Op, Rest;
+  std::tie(Op, Rest) = Text.split(" on Line ");
+  if (Rest.empty()) {
+    StringRef LineText, ColText;
+    std::tie(LineText, ColText) = Text.split(", ");
+    if (!LineText.getAsInteger(10, Line) && !ColText.getAsInteger(10, Col))
+      Record.Locations.emplace_back(Line, Col);
+    return;
+  }
+
+  StringRef LineText, ColText, First, Second;
+  std::tie(LineText, Rest) = Rest.split(", Column ");
+  std::tie(ColText, Rest) = Rest.split(" with first operand ");
+  std::tie(First, Second) = Rest.split(" and second operand ");
+  if (Record.Locations.empty() || LineText.getAsInteger(10, Line) ||
+      ColText.getAsInteger(10, Col))
+    return;
+  Record.BinOps.push_back({Record.Locations.size() - 1, Line, Col, Op.str(),
+                           First.str(), Second.str()});
+}
+
+/**
+ * Run the function pass on F and collect what it prints. The pass only
+ * reads F, so different functions of a module can be analysed concurrently
+ * as long as each thread has its own MST.
+ */
+static void analyzeFunction(Function &F, ModuleSlotTracker &MST,
+                            FunctionRecord &Record) {
+  Record.Name = F.getName().str();
+  MST.incorporateFunction(F);
+  SlotTrackerScope Scope(MST);
+
+  std::string Output;
+  raw_string_ostream OS(Output);
+  Instrument P(OS);
+  P.runOnFunction(F);
+  OS.flush();
+
+  SmallVector<StringRef, 64> Lines;
+  StringRef(Output).split(Lines, '\n', /*MaxSplit=*/-1, /*KeepEmpty=*/false);
+  for (StringRef Text : Lines)
+    parseLine(Text, Record);
+}
+
+static void writeJSONReport(raw_ostream &OS, StringRef ModuleName,
+                            ArrayRef<FunctionRecord> Records) {
+  json::OStream J(OS);
+  J.object([&] {
+    J.attribute("module", ModuleName);
+    J.attributeArray("functions", [&] {
+      for (const FunctionRecord &Record : Records) {
+        J.object([&] {
+          J.attribute("name", Record.Name);
+          J.attributeArray("locations", [&] {
+            for (const auto &Loc : Record.Locations)
+              J.value(json::Array{Loc.first, Loc.second});
+          });
+          J.attributeArray("binops", [&] {
+            for (const BinOpRecord &BinOp : Record.BinOps) {
+              J.object([&] {
+                J.attribute("op", BinOp.Op);
+                J.attribute("line", BinOp.Line);
+                J.attribute("col", BinOp.Col);
+                J.attribute("first", BinOp.FirstOperand);
+                J.attribute("second", BinOp.SecondOperand);
+              });
+            }
+          });
+        });
+      }
+    });
+  });
+  OS << "\n";
+}
+
+/**
+ * Write one CSV field, quoted and with its quotes doubled as RFC 4180 asks,
+ * so that operand names holding commas, quotes or newlines stay in one field.
+ */
+static void writeCSVField(raw_ostream &OS, StringRef Field) {
+  OS << '"';
+  for (char C : Field) {
+    if (C == '"')
+      OS << '"';
+    OS << C;
+  }
+  OS << '"';
+}
+
+static void writeCSVRow(raw_ostream &OS, ArrayRef<std::string> Fields) {
+  for (size_t I = 0; I < Fields.size(); ++I) {
+    if (I > 0)
+      OS << ",";
+    writeCSVField(OS, Fields[I]);
+  }
+  OS << "\n";
+}
+
+static void writeCSVReport(raw_ostream &OS, ArrayRef<FunctionRecord> Records) {
+  writeCSVRow(OS, {"function", "line", "col", "op", "first", "second"});
+  for (const FunctionRecord &Record : Records) {
+    // Binary operators are recorded in instruction order, so a single merge
+    // puts every operator on the row of its own instruction.
+    size_t Next = 0;
+    for (size_t I = 0; I < Record.Locations.size(); ++I) {
+      const auto &Loc = Record.Locations[I];
+      std::string Op, First, Second;
+      if (Next < Record.BinOps.size() && Record.BinOps[Next].Location == I) {
+        const BinOpRecord &BinOp = Record.BinOps[Next++];
+        Op = BinOp.Op;
+        First = BinOp.FirstOperand;
+        Second = BinOp.SecondOperand;
+      }
+      writeCSVRow(OS, {Record.Name, std::to_string(Loc.first),
+                       std::to_string(Loc.second), Op, First, Second});
+    }
+  }
+}
+
 bool Instrument::runOnFunction(Function &F) {
   auto FunctionName = F.getName().str();
-  outs() << "Running " << PASS_DESC << " on function " << FunctionName << "\n";
-  outs() << "Locating Instructions\n";
+  OS << "Running " << PASS_DESC << " on function " << FunctionName << "\n";
+  OS << "Locating Instructions\n";
 
   for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
     Instruction &Inst = (*Iter);
@@ -36,12 +215,12 @@ bool Instrument::runOnFunction(Function &F) {
 
     int Line = DebugLoc.getLine();
     int Col = DebugLoc.getCol();
-    outs() << Line << ", " << Col << "\n";
+    OS << Line << ", " << Col << "\n";
 
     /**
      * TODO: Add code to check if instruction is a BinaryOperator and if so,
-     * print information about its location and operands as specified in Lab
-     * document.
+     * print information about its location and operands to OS as specified
+     * in Lab document.
      */
   }
   return false;
@@ -49,7 +228,62 @@ bool Instrument::runOnFunction(Function &F) {
 
 char Instrument::ID = 1;
 
-struct StaticAnalysisNPMWrapper : public PassInfoMixin<StaticAnalysisNPMWrapper> {
+/**
+ * Module-level driver: runs the function pass on all defined functions on a
+ * thread pool and emits what it prints as a single report in module order.
+ */
+struct StaticAnalysisModulePass
+    : public PassInfoMixin<StaticAnalysisModulePass> {
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &) {
+    std::vector<Function *> Functions;
+    for (Function &F : M) {
+      if (!F.isDeclaration())
+        Functions.push_back(&F);
+    }
+
+    std::vector<FunctionRecord> Records(Functions.size());
+    {
+      // One task per worker, each pulling chunks of functions from a shared
+      // counter. Every worker numbers the module's slots once in its own
+      // tracker, which variable() reuses, rather than once per printed
+      // operand.
+      const size_t ChunkSize = 64;
+      size_t NumChunks = (Functions.size() + ChunkSize - 1) / ChunkSize;
+      ThreadPoolStrategy Strategy = hardware_concurrency(ReportThreads);
+      size_t NumWorkers =
+          std::min<size_t>(Strategy.compute_thread_count(), NumChunks);
+      std::atomic<size_t> NextChunk(0);
+
+      DefaultThreadPool Pool(Strategy);
+      for (size_t W = 0; W < NumWorkers; ++W) {
+        Pool.async([&] {
+          ModuleSlotTracker MST(&M);
+          for (size_t C = NextChunk++; C < NumChunks; C = NextChunk++) {
+            size_t End = std::min((C + 1) * ChunkSize, Functions.size());
+            for (size_t I = C * ChunkSize; I < End; ++I)
+              analyzeFunction(*Functions[I], MST, Records[I]);
+          }
+        });
+      }
+      Pool.wait();
+    }
+
+    std::error_code EC;
+    raw_fd_ostream OS(ReportPath, EC, sys::fs::OF_Text);
+    if (EC) {
+      errs() << "Cannot open " << ReportPath << ": " << EC.message() << "\n";
+      return PreservedAnalyses::all();
+    }
+    if (ReportKind == ReportFormat::JSON)
+      writeJSONReport(OS, M.getModuleIdentifier(), Records);
+    else
+      writeCSVReport(OS, Records);
+    return PreservedAnalyses::all();
+  }
+};
+
+struct StaticAnalysisNPMWrapper
+    : public PassInfoMixin<StaticAnalysisNPMWrapper> {
   PreservedAnalyses run(Function &F, FunctionAnalysisManager &) {
     Instrument P;
     bool Modified = P.runOnFunction(F);
@@ -72,10 +306,19 @@ extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
               }
               return false;
             });
+        PB.registerPipelineParsingCallback(
+            [](StringRef Name, ModulePassManager &MPM,
+               ArrayRef<PassBuilder::PipelineElement>) {
+              if (Name == "static-analysis-module") {
+                MPM.addPass(StaticAnalysisModulePass());
+                return true;
+              }
+              return false;
+            });
         PB.registerPipelineStartEPCallback(
             [](ModulePassManager &MPM, OptimizationLevel) {
-              MPM.addPass(
-                  createModuleToFunctionPassAdaptor(StaticAnalysisNPMWrapper()));
+              MPM.addPass(createModuleToFunctionPassAdaptor(
+                  StaticAnalysisNPMWrapper()));
             });
       }};
 }
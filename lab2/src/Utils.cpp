@@ -1,6 +1,7 @@
 #include "Utils.h"
 
 #include "llvm/IR/Instruction.h"
+#include "llvm/IR/ModuleSlotTracker.h"
 #include "llvm/IR/Value.h"
 #include "llvm/Support/raw_ostream.h"
 #include <string>
@@ -50,16 +51,43 @@ const std::string getBinOpName(const char symbol) {
   }
 }
 
-std::string variable(Value *V) {
-  std::string Code;
-  raw_string_ostream SS(Code);
-  V->print(SS);
-  SS.flush();
-
+static std::string operandName(std::string Code) {
   Code.erase(0, Code.find_first_not_of(WHITESPACES));
   auto RetVal = Code.substr(0, Code.find_first_of(WHITESPACES));
   if (RetVal == "i32") {
     return Code.substr(Code.find_first_of(WHITESPACES) + 1, Code.length());
   }
   return RetVal;
-}
\ No newline at end of file
+}
+
+// Set by SlotTrackerScope.
+static thread_local ModuleSlotTracker *CurrentMST = nullptr;
+
+SlotTrackerScope::SlotTrackerScope(ModuleSlotTracker &MST) : Saved(CurrentMST) {
+  CurrentMST = &MST;
+}
+
+SlotTrackerScope::~SlotTrackerScope() { CurrentMST = Saved; }
+
+std::string variable(Value *V) {
+  if (CurrentMST)
+    return variable(V, *CurrentMST);
+  std::string Code;
+  raw_string_ostream SS(Code);
+  V->print(SS);
+  SS.flush();
+  return operandName(Code);
+}
+
+std::string variable(Value *V, ModuleSlotTracker &MST) {
+  std::string Code;
+  raw_string_ostream SS(Code);
+  // Printing a whole instruction only to keep the name before " = " sets up
+  // a module-wide writer on every call; print just the operand instead.
+  if (isa<Instruction>(V))
+    V->printAsOperand(SS, /* PrintType */ false, MST);
+  else
+    V->print(SS, MST);
+  SS.flush();
+  return operandName(Code);
+}
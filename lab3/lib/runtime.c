@@ -1,3 +1,8 @@
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -29,10 +34,173 @@ void __sanitize__(int divisor, int line, int col) {
   }
 }
 
-void __coverage__(int line, int col) {
+/*
+ * Thread-safe coverage logging.
+ *
+ * Every thread formats its records into a private buffer and appends the
+ * whole buffer to the log with a single write() on a shared O_APPEND
+ * descriptor when it fills up, so probes never share a lock or a FILE*.
+ * Buffers are flushed when their thread exits, at exit() (which is how
+ * `__sanitize__` stops the program), and on fatal signals, so the fuzzer
+ * still sees the coverage of crashing inputs.
+ *
+ * A probe holds the busy flag of its own thread while it appends a record.
+ * exit() and the signal handler take the flag of every thread that is still
+ * running before flushing its buffer, so they never write half a record.
+ */
+
+#define LOG_BUFFER_SIZE 4096
+#define LOG_RECORD_MAX_SIZE 64
+
+static atomic_int coverage_fd = -1;
+
+struct thread_state {
+  // Set while __coverage__, finish_runtime() or flush_on_signal() uses it.
+  atomic_flag busy;
+  size_t len;
+  char data[LOG_BUFFER_SIZE];
+  struct thread_state *prev;
+  struct thread_state *next;
+};
+
+static pthread_once_t runtime_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_state_key;
+static pthread_mutex_t threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct thread_state *threads = NULL;
+static _Thread_local struct thread_state *self = NULL;
+
+static int get_coverage_fd(void) {
+  int fd = atomic_load(&coverage_fd);
+  if (fd >= 0)
+    return fd;
   char logfile[STR_MAX_SIZE];
   get_logfile(logfile, sizeof(logfile), ".cov");
-  FILE *f = fopen(logfile, "a");
-  fprintf(f, "%d, %d\n", line, col);
-  fclose(f);
+  int opened = open(logfile, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  if (opened == -1) {
+    fprintf(stderr, "Error: Cannot open %s\n", logfile);
+    exit(1);
+  }
+  int expected = -1;
+  if (!atomic_compare_exchange_strong(&coverage_fd, &expected, opened)) {
+    close(opened);
+    return expected;
+  }
+  return opened;
+}
+
+// Only uses async-signal-safe calls once the log file is open.
+static void flush_coverage(struct thread_state *ts) {
+  size_t off = 0;
+  if (!ts->len)
+    return;
+  int fd = get_coverage_fd();
+  while (off < ts->len) {
+    ssize_t n = write(fd, ts->data + off, ts->len - off);
+    if (n <= 0)
+      break;
+    off += n;
+  }
+  ts->len = 0;
+}
+
+static void lock_thread_state(struct thread_state *ts) {
+  while (atomic_flag_test_and_set_explicit(&ts->busy, memory_order_acquire))
+    sched_yield();
+}
+
+static void unlock_thread_state(struct thread_state *ts) {
+  atomic_flag_clear_explicit(&ts->busy, memory_order_release);
+}
+
+// Runs in the exiting thread, so no probe can use ts any more.
+static void release_thread_state(void *arg) {
+  struct thread_state *ts = arg;
+  pthread_mutex_lock(&threads_lock);
+  flush_coverage(ts);
+  if (ts->prev)
+    ts->prev->next = ts->next;
+  else
+    threads = ts->next;
+  if (ts->next)
+    ts->next->prev = ts->prev;
+  pthread_mutex_unlock(&threads_lock);
+  free(ts);
+}
+
+static void finish_runtime(void) {
+  pthread_mutex_lock(&threads_lock);
+  for (struct thread_state *ts = threads; ts; ts = ts->next) {
+    lock_thread_state(ts);
+    flush_coverage(ts);
+    unlock_thread_state(ts);
+  }
+  pthread_mutex_unlock(&threads_lock);
+}
+
+static const int fatal_signals[] = {SIGSEGV, SIGFPE, SIGBUS, SIGILL, SIGABRT};
+#define NUM_FATAL_SIGNALS (sizeof(fatal_signals) / sizeof(fatal_signals[0]))
+static struct sigaction old_actions[NUM_FATAL_SIGNALS];
+
+/*
+ * The crashing thread may hold threads_lock, so walk the list without it,
+ * and skip the threads caught in the middle of a probe, the crashing one
+ * included, rather than wait for them.
+ */
+static void flush_on_signal(int sig) {
+  if (atomic_load(&coverage_fd) >= 0)
+    for (struct thread_state *ts = threads; ts; ts = ts->next) {
+      if (atomic_flag_test_and_set_explicit(&ts->busy, memory_order_acquire))
+        continue;
+      flush_coverage(ts);
+      unlock_thread_state(ts);
+    }
+  for (size_t i = 0; i < NUM_FATAL_SIGNALS; ++i)
+    if (fatal_signals[i] == sig)
+      sigaction(sig, &old_actions[i], NULL);
+  raise(sig);
+}
+
+static void init_runtime(void) {
+  pthread_key_create(&thread_state_key, release_thread_state);
+  atexit(finish_runtime);
+
+  // Open the log up front so the signal handler never has to.
+  get_coverage_fd();
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = flush_on_signal;
+  sigemptyset(&action.sa_mask);
+  for (size_t i = 0; i < NUM_FATAL_SIGNALS; ++i)
+    sigaction(fatal_signals[i], &action, &old_actions[i]);
+}
+
+static struct thread_state *get_thread_state(void) {
+  if (self)
+    return self;
+  pthread_once(&runtime_once, init_runtime);
+  self = calloc(1, sizeof(*self));
+  if (!self) {
+    fprintf(stderr, "Error: Cannot allocate thread state\n");
+    exit(1);
+  }
+  pthread_mutex_lock(&threads_lock);
+  self->next = threads;
+  if (threads)
+    threads->prev = self;
+  threads = self;
+  pthread_mutex_unlock(&threads_lock);
+  // The main thread does not run key destructors; finish_runtime covers it.
+  pthread_setspecific(thread_state_key, self);
+  return self;
+}
+
+void __coverage__(int line, int col) {
+  struct thread_state *ts = get_thread_state();
+  lock_thread_state(ts);
+  if (ts->len + LOG_RECORD_MAX_SIZE > LOG_BUFFER_SIZE)
+    flush_coverage(ts);
+  ts->len += snprintf(ts->data + ts->len, LOG_RECORD_MAX_SIZE, "%d, %d\n",
+                      line, col);
+  unlock_thread_state(ts);
 }
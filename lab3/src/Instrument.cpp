@@ -9,6 +9,7 @@
 #include "llvm/Passes/OptimizationLevel.h"
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
+#include "llvm/Support/CommandLine.h"
 
 using namespace llvm;
 
@@ -20,6 +21,16 @@ const auto PASS_NAME = "InstrumentPass";
 static const char *SANITIZE_FUNCTION_NAME = "__sanitize__";
 static const char *COVERAGE_FUNCTION_NAME = "__coverage__";
 
+// Metadata the DivZero-annotate pass of lab7 puts on divisions whose divisor
+// it proved NonZero, and module flag it sets on the modules it annotated.
+static const char *SAFE_DIVISION_METADATA = "divzero.safe";
+static const char *ANNOTATED_MODULE_FLAG = "divzero.annotated";
+
+static cl::opt<bool> ElideSafeDivs(
+    "instrument-elide-safe-divs",
+    cl::desc("Do not sanitize divisions the DivZero analysis proved safe"),
+    cl::init(false));
+
 /**
  * @brief Instruments given instruction with coverage logging.
  *
@@ -102,6 +113,13 @@ bool Instrument::runOnFunction(Function &F) {
   M->getOrInsertFunction(SANITIZE_FUNCTION_NAME, VoidType, Int32Type, Int32Type,
                          Int32Type);
 
+  // The metadata is only trusted if DivZero-annotate ran on this module.
+  bool Elide = ElideSafeDivs && M->getModuleFlag(ANNOTATED_MODULE_FLAG);
+
+  // Number of divisions, and of those left unsanitized.
+  unsigned NumDivs = 0;
+  unsigned NumElided = 0;
+
   // Iterate over each instruction in function.
   for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
     // Skip PHI nodes as they are not actual executable instructions.
@@ -121,14 +139,34 @@ bool Instrument::runOnFunction(Function &F) {
 
     // If instruction is a signed or unsigned division, instrument it for
     // sanitization.
+    // Divisions whose divisor was proved NonZero are skipped on request.
     if (I->getOpcode() == Instruction::SDiv ||
         I->getOpcode() == Instruction::UDiv) {
-      instrumentSanitize(M, *I, Line, Col);
+      ++NumDivs;
+      if (Elide && I->getMetadata(SAFE_DIVISION_METADATA)) {
+        ++NumElided;
+      } else {
+        instrumentSanitize(M, *I, Line, Col);
+      }
     }
 
     instrumentCoverage(M, *I, Line, Col);
   }
 
+  if (ElideSafeDivs && NumDivs > 0) {
+    // The pass runs function by function, and doInitialization is not
+    // called through the NPM wrapper, so remember the last module warned
+    // about to warn only once per module.
+    static const Module *WarnedModule = nullptr;
+    if (!Elide && WarnedModule != M) {
+      WarnedModule = M;
+      errs() << "Warning: " << M->getName()
+             << " was not annotated by DivZero-annotate, no check elided\n";
+    }
+    errs() << "Elided " << NumElided << " of " << NumDivs
+           << " division checks in " << F.getName() << "\n";
+  }
+
   return true;
 }
 
@@ -0,0 +1,10 @@
+#include <stdio.h>
+
+int main() {
+  char input[65536];
+  fgets(input, sizeof(input), stdin);
+  int x = input[0];
+  int y = x / 4;
+  int z = 100 / (x - 'a');
+  return 0;
+}
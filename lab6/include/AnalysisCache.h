@@ -0,0 +1,67 @@
+#ifndef ANALYSIS_CACHE_H
+#define ANALYSIS_CACHE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Function.h"
+
+#include <string>
+#include <vector>
+
+#include "AbstractMemory.h"
+
+namespace dataflow {
+
+/**
+ * @brief Results of the analysis of one function, as stored in the cache.
+ * Instructions are identified by their index in the function.
+ */
+struct CachedResult {
+  std::vector<Memory> In;
+  std::vector<Memory> Out;
+  std::vector<unsigned> ErrorInsts;
+};
+
+/**
+ * @brief On-disk cache of analysis results, one file per function.
+ *
+ * A result is keyed by the MD5 of the printed IR of the function, the
+ * analysis version, the build of the plugin and the options that change the
+ * result, so any change to the function or to the analysis code invalidates
+ * it. Files are written to a temporary name and
+ * then renamed, so concurrent writers never expose a partial entry. Any
+ * error, e.g. a missing or corrupt file, is treated as a miss.
+ */
+class AnalysisCache {
+public:
+  /**
+   * @brief Bump whenever a change to the analysis changes its results or
+   * the file format changes.
+   */
+  static const unsigned Version = 1;
+
+  explicit AnalysisCache(StringRef Dir) : Dir(Dir.str()) {}
+
+  /**
+   * @brief Compute the key of F.
+   *
+   * @param F Function to be analyzed.
+   * @param Config Options of the analysis that change its result.
+   */
+  std::string getKey(const Function &F, StringRef Config) const;
+
+  /**
+   * @return true if a result for Key was found and read into Result.
+   */
+  bool load(StringRef Key, CachedResult &Result) const;
+
+  void store(StringRef Key, const CachedResult &Result) const;
+
+private:
+  std::string Dir;
+
+  std::string getPath(StringRef Key) const;
+};
+
+} // namespace dataflow
+
+#endif // ANALYSIS_CACHE_H
@@ -1,12 +1,13 @@
 #ifndef DIV_ZERO_ANALYSIS_H
 #define DIV_ZERO_ANALYSIS_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
-#include "llvm/IR/ValueMap.h"
+#include "llvm/IR/ModuleSlotTracker.h"
 #include "llvm/Pass.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -20,18 +21,43 @@
 #include <map>
 #include <string>
 
+#include "AbstractMemory.h"
+#include "AnalysisCache.h"
 #include "Domain.h"
+#include "ValueNumbering.h"
 
 namespace dataflow {
 
-using Memory = std::map<std::string, Domain *>;
-
 struct DivZeroAnalysis : public FunctionPass {
   static char ID;
   DivZeroAnalysis() : FunctionPass(ID) {}
-  ValueMap<Instruction *, Memory *> InMap;
-  ValueMap<Instruction *, Memory *> OutMap;
+  DenseMap<Instruction *, Memory *> InMap;
+  DenseMap<Instruction *, Memory *> OutMap;
   SetVector<Instruction *> ErrorInsts;
+  ValueNumbering *Numbering = nullptr;
+
+  /**
+   * Streams runOnFunction() prints its results and the dataflow map to, and
+   * the slot numbering used to print instructions, if any. The module pass
+   * gives every function its own buffers and every worker its own tracker.
+   */
+  raw_ostream *ResultStream = &outs();
+  raw_ostream *MapStream = &errs();
+  ModuleSlotTracker *SlotTracker = nullptr;
+
+  /**
+   * Memory at the entry of every reachable basic block, as computed by
+   * doBlockAnalysis().
+   */
+  DenseMap<BasicBlock *, Memory> BlockIn;
+
+  /**
+   * Results of doSparseAnalysis(): the Domain of every SSA value, which is
+   * the In and Out Memory of every executable instruction, and the empty
+   * Memory of unreachable instructions.
+   */
+  Memory SparseState;
+  Memory UnreachableState;
 
   /**
    * This function is called for each function F in input C program
@@ -76,6 +102,54 @@ protected:
   void flowOut(Instruction *Inst, Memory *Pre, Memory *Post,
                SetVector<Instruction *> &WorkSet);
 
+  /**
+   * @brief Block-level solver: keeps Memory only at the entry and exit of
+   * each basic block and visits blocks in reverse postorder. Part of the
+   * reference library, like materialize() and doSparseAnalysis().
+   *
+   * @param F Function to be analyzed.
+   */
+  void doBlockAnalysis(Function &F);
+
+  /**
+   * @brief Apply the transfer function of every instruction in BB to State.
+   *
+   * @param BB Basic block to evaluate.
+   * @param State Memory at the entry of BB, updated to its exit.
+   * @param Record If true, also store In and Out Memory of every instruction
+   * in InMap and OutMap.
+   */
+  void transferBlock(BasicBlock *BB, Memory &State, bool Record);
+
+  /**
+   * @brief Rebuild In and Out Memory of every instruction in BB from the
+   * block states computed by doBlockAnalysis().
+   */
+  void materialize(BasicBlock *BB);
+
+  /**
+   * @brief Sparse solver: keeps one Domain per SSA value and propagates it
+   * along def-use chains over the executable edges of the CFG.
+   *
+   * @param F Function to be analyzed.
+   */
+  void doSparseAnalysis(Function &F);
+
+  /**
+   * @brief Fill InMap, OutMap and ErrorInsts from the result cached under
+   * Key, if there is one.
+   *
+   * @return true if a result was found.
+   */
+  bool loadCachedResult(Function &F, const AnalysisCache &Cache,
+                        StringRef Key);
+
+  /**
+   * @brief Store InMap, OutMap and ErrorInsts in the cache under Key.
+   */
+  void storeCachedResult(Function &F, const AnalysisCache &Cache,
+                         StringRef Key);
+
   /**
    * Can Instruction Inst incurr a divide by zero error?
    *
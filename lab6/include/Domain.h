@@ -3,6 +3,8 @@
 
 #include "llvm/Support/raw_ostream.h"
 
+#include <cstdint>
+
 using namespace llvm;
 
 namespace dataflow {
@@ -13,23 +15,141 @@ namespace dataflow {
 
 /*
  * Implement your abstract domain.
+ *
+ * A Domain is a one-byte value; the abstract operators are table lookups and
+ * never allocate.
  */
 class Domain {
 public:
-  enum Element { Uninit, NonZero, Zero, MaybeZero };
-  Domain();
-  Domain(Element V);
+  enum Element : uint8_t { Uninit, NonZero, Zero, MaybeZero };
+  constexpr Domain() : Value(Uninit) {}
+  constexpr Domain(Element V) : Value(V) {}
   Element Value;
 
-  static Domain *add(Domain *E1, Domain *E2);
-  static Domain *sub(Domain *E1, Domain *E2);
-  static Domain *mul(Domain *E1, Domain *E2);
-  static Domain *div(Domain *E1, Domain *E2);
-  static Domain *join(Domain *E1, Domain *E2);
-  static bool equal(Domain E1, Domain E2);
-  void print(raw_ostream &O);
+  static constexpr Domain add(Domain E1, Domain E2);
+  static constexpr Domain sub(Domain E1, Domain E2);
+  static constexpr Domain mul(Domain E1, Domain E2);
+  static constexpr Domain div(Domain E1, Domain E2);
+  static constexpr Domain join(Domain E1, Domain E2);
+  static constexpr Domain meet(Domain E1, Domain E2);
+  static constexpr bool equal(Domain E1, Domain E2);
+  void print(raw_ostream &O) const;
 };
 
+namespace detail {
+
+using E = Domain::Element;
+
+// Transfer tables, indexed by [E1][E2] in the order of Domain::Element.
+constexpr E AddTable[4][4] = {
+    {E::Uninit, E::Uninit, E::Uninit, E::Uninit},
+    {E::Uninit, E::MaybeZero, E::NonZero, E::MaybeZero},
+    {E::Uninit, E::NonZero, E::Zero, E::MaybeZero},
+    {E::Uninit, E::MaybeZero, E::MaybeZero, E::MaybeZero}};
+
+constexpr E MulTable[4][4] = {
+    {E::Uninit, E::Uninit, E::Uninit, E::Uninit},
+    {E::Uninit, E::NonZero, E::Zero, E::MaybeZero},
+    {E::Uninit, E::Zero, E::Zero, E::Zero},
+    {E::Uninit, E::MaybeZero, E::Zero, E::MaybeZero}};
+
+constexpr E DivTable[4][4] = {
+    {E::Uninit, E::Uninit, E::Uninit, E::Uninit},
+    {E::Uninit, E::MaybeZero, E::Uninit, E::Uninit},
+    {E::Uninit, E::Zero, E::Uninit, E::Uninit},
+    {E::Uninit, E::MaybeZero, E::Uninit, E::Uninit}};
+
+constexpr E JoinTable[4][4] = {
+    {E::Uninit, E::NonZero, E::Zero, E::MaybeZero},
+    {E::NonZero, E::NonZero, E::MaybeZero, E::MaybeZero},
+    {E::Zero, E::MaybeZero, E::Zero, E::MaybeZero},
+    {E::MaybeZero, E::MaybeZero, E::MaybeZero, E::MaybeZero}};
+
+constexpr E MeetTable[4][4] = {
+    {E::Uninit, E::Uninit, E::Uninit, E::Uninit},
+    {E::Uninit, E::NonZero, E::Uninit, E::NonZero},
+    {E::Uninit, E::Uninit, E::Zero, E::Zero},
+    {E::Uninit, E::NonZero, E::Zero, E::MaybeZero}};
+
+} // namespace detail
+
+/**
+ * @brief Add two domain elements.
+ *
+ * @param E1 1st domain element.
+ * @param E2 2nd domain element.
+ * @return Domain element representing addition result.
+ */
+constexpr Domain Domain::add(Domain E1, Domain E2) {
+  return Domain(detail::AddTable[E1.Value][E2.Value]);
+}
+
+/**
+ * @brief Subtract two domain elements.
+ *
+ * @param E1 1st domain element.
+ * @param E2 2nd domain element.
+ * @return Domain element representing subtraction result.
+ */
+constexpr Domain Domain::sub(Domain E1, Domain E2) {
+  return Domain(detail::AddTable[E1.Value][E2.Value]);
+}
+
+/**
+ * @brief Multiply two domain elements.
+ *
+ * @param E1 1st domain element.
+ * @param E2 2nd domain element.
+ * @return Domain element representing multiplication result.
+ */
+constexpr Domain Domain::mul(Domain E1, Domain E2) {
+  return Domain(detail::MulTable[E1.Value][E2.Value]);
+}
+
+/**
+ * @brief Divide two domain elements.
+ *
+ * @param E1 1st domain element.
+ * @param E2 2nd domain element.
+ * @return Domain element representing division result.
+ */
+constexpr Domain Domain::div(Domain E1, Domain E2) {
+  return Domain(detail::DivTable[E1.Value][E2.Value]);
+}
+
+/**
+ * @brief Join two domain elements.
+ *
+ * @param E1 1st domain element.
+ * @param E2 2nd domain element.
+ * @return Domain element representing join result.
+ */
+constexpr Domain Domain::join(Domain E1, Domain E2) {
+  return Domain(detail::JoinTable[E1.Value][E2.Value]);
+}
+
+/**
+ * @brief Meet two domain elements.
+ *
+ * @param E1 1st domain element.
+ * @param E2 2nd domain element.
+ * @return Domain element representing meet result.
+ */
+constexpr Domain Domain::meet(Domain E1, Domain E2) {
+  return Domain(detail::MeetTable[E1.Value][E2.Value]);
+}
+
+/**
+ * @brief Check if two domain elements are equal.
+ *
+ * @param E1 1st domain element.
+ * @param E2 2nd domain element.
+ * @return true if elements are equal, false otherwise.
+ */
+constexpr bool Domain::equal(Domain E1, Domain E2) {
+  return E1.Value == E2.Value;
+}
+
 raw_ostream &operator<<(raw_ostream &O, Domain V);
 
 } // namespace dataflow
@@ -0,0 +1,198 @@
+#ifndef INTERVAL_H
+#define INTERVAL_H
+
+#include "MonotoneSolver.h"
+#include "ValueNumbering.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Interval Domain
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief A set of integers [Lo, Hi]; the interval is empty if Lo > Hi.
+ *
+ * Bounds are signed. Only integers of at most 32 bits are tracked, so that
+ * the bounds of an addition or multiplication always fit in 64 bits; wider
+ * integers are always top().
+ */
+struct Interval {
+  static const unsigned MaxBits = 32;
+
+  int64_t Lo;
+  int64_t Hi;
+
+  Interval() : Lo(1), Hi(0) {}
+  Interval(int64_t Lo, int64_t Hi) : Lo(Lo), Hi(Hi) {}
+
+  static Interval bottom() { return Interval(); }
+  static Interval constant(int64_t C) { return Interval(C, C); }
+
+  /**
+   * @brief Every value of a Bits-wide integer.
+   */
+  static Interval top(unsigned Bits) {
+    if (Bits > MaxBits)
+      return Interval(std::numeric_limits<int64_t>::min(),
+                      std::numeric_limits<int64_t>::max());
+    return Interval(-(int64_t(1) << (Bits - 1)),
+                    (int64_t(1) << (Bits - 1)) - 1);
+  }
+
+  bool isEmpty() const { return Lo > Hi; }
+  bool contains(int64_t C) const { return Lo <= C && C <= Hi; }
+  bool leq(const Interval &Other) const {
+    return isEmpty() || (Other.Lo <= Lo && Hi <= Other.Hi);
+  }
+  bool operator==(const Interval &Other) const {
+    return (isEmpty() && Other.isEmpty()) ||
+           (Lo == Other.Lo && Hi == Other.Hi);
+  }
+  bool operator!=(const Interval &Other) const { return !(*this == Other); }
+
+  static Interval join(const Interval &A, const Interval &B) {
+    if (A.isEmpty())
+      return B;
+    if (B.isEmpty())
+      return A;
+    return Interval(std::min(A.Lo, B.Lo), std::max(A.Hi, B.Hi));
+  }
+
+  static Interval meet(const Interval &A, const Interval &B) {
+    return Interval(std::max(A.Lo, B.Lo), std::min(A.Hi, B.Hi));
+  }
+
+  void print(raw_ostream &O) const {
+    if (isEmpty())
+      O << "[]";
+    else
+      O << "[" << Lo << ", " << Hi << "]";
+  }
+};
+
+inline raw_ostream &operator<<(raw_ostream &O, const Interval &I) {
+  I.print(O);
+  return O;
+}
+
+/**
+ * @brief Abstract state of the interval analysis: maps the number of a
+ * variable (see ValueNumbering) to its Interval. Variables that were never
+ * set are empty.
+ */
+class IntervalMemory {
+public:
+  Interval get(unsigned N) const {
+    return N < Values.size() ? Values[N] : Interval::bottom();
+  }
+
+  void set(unsigned N, Interval I) {
+    if (N == ValueNumbering::None)
+      return;
+    if (N >= Values.size())
+      Values.resize(N + 1);
+    Values[N] = I;
+  }
+
+  void join(const IntervalMemory &Other) {
+    if (Values.size() < Other.Values.size())
+      Values.resize(Other.Values.size());
+    for (size_t I = 0, E = Other.Values.size(); I < E; ++I)
+      Values[I] = Interval::join(Values[I], Other.Values[I]);
+  }
+
+  bool leq(const IntervalMemory &Other) const {
+    for (size_t I = 0, E = Values.size(); I < E; ++I) {
+      if (!Values[I].leq(Other.get(I)))
+        return false;
+    }
+    return true;
+  }
+
+  unsigned size() const { return Values.size(); }
+
+private:
+  std::vector<Interval> Values;
+};
+
+/**
+ * @brief Lattice operations of IntervalMemory with threshold widening: a
+ * bound that grows jumps to the next threshold, typically a constant the
+ * function compares against, instead of straight to infinity.
+ */
+struct IntervalTraits {
+  /// Sorted, without duplicates.
+  std::vector<int64_t> Thresholds;
+
+  IntervalMemory bottom() const { return IntervalMemory(); }
+  void join(IntervalMemory &Into, const IntervalMemory &Other) const {
+    Into.join(Other);
+  }
+  bool leq(const IntervalMemory &A, const IntervalMemory &B) const {
+    return A.leq(B);
+  }
+
+  IntervalMemory widen(const IntervalMemory &Old,
+                       const IntervalMemory &New) const {
+    IntervalMemory Result(New);
+    for (unsigned N = 0, E = New.size(); N < E; ++N)
+      Result.set(N, widen(Old.get(N), New.get(N)));
+    return Result;
+  }
+
+  IntervalMemory narrow(const IntervalMemory &Old,
+                        const IntervalMemory &New) const {
+    IntervalMemory Result(New);
+    for (unsigned N = 0, E = New.size(); N < E; ++N)
+      Result.set(N, narrow(Old.get(N), New.get(N)));
+    return Result;
+  }
+
+  Interval widen(const Interval &Old, const Interval &New) const {
+    if (Old.isEmpty() || New.isEmpty())
+      return Interval::join(Old, New);
+    int64_t Lo = Old.Lo, Hi = Old.Hi;
+    if (New.Lo < Lo) {
+      auto It = std::upper_bound(Thresholds.begin(), Thresholds.end(), New.Lo);
+      Lo = It == Thresholds.begin() ? std::numeric_limits<int64_t>::min()
+                                    : *(It - 1);
+    }
+    if (New.Hi > Hi) {
+      auto It = std::lower_bound(Thresholds.begin(), Thresholds.end(), New.Hi);
+      Hi = It == Thresholds.end() ? std::numeric_limits<int64_t>::max() : *It;
+    }
+    return Interval(Lo, Hi);
+  }
+
+  /**
+   * @brief Only refine the bounds that widening may have overshot, i.e. those
+   * at a threshold or at infinity.
+   */
+  Interval narrow(const Interval &Old, const Interval &New) const {
+    if (Old.isEmpty() || New.isEmpty())
+      return New;
+    int64_t Lo = Old.Lo, Hi = Old.Hi;
+    if (isThreshold(Lo) || Lo == std::numeric_limits<int64_t>::min())
+      Lo = New.Lo;
+    if (isThreshold(Hi) || Hi == std::numeric_limits<int64_t>::max())
+      Hi = New.Hi;
+    return Interval(Lo, Hi);
+  }
+
+private:
+  bool isThreshold(int64_t C) const {
+    return std::binary_search(Thresholds.begin(), Thresholds.end(), C);
+  }
+};
+
+} // namespace dataflow
+
+#endif // INTERVAL_H
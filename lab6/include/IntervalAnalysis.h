@@ -0,0 +1,66 @@
+#ifndef INTERVAL_ANALYSIS_H
+#define INTERVAL_ANALYSIS_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+
+#include "Interval.h"
+#include "MonotoneSolver.h"
+#include "ValueNumbering.h"
+
+namespace dataflow {
+
+/**
+ * @brief Range of every integer variable of a function, at every program
+ * point.
+ *
+ * Runs MonotoneSolver over IntervalMemory. Loops are widened at the headers
+ * found by LoopInfo, using the constants the function compares against as
+ * thresholds, and the fixpoint is then refined by a few narrowing passes.
+ * Conditional branches on an icmp refine the operands of the comparison in
+ * the blocks they alone lead to, which is what lets narrowing recover loop
+ * bounds.
+ */
+class IntervalAnalysis {
+public:
+  /**
+   * @brief Number of descending passes after the widened fixpoint.
+   */
+  static const unsigned NarrowingRounds = 2;
+
+  IntervalAnalysis(Function &F, const ValueNumbering &VN);
+
+  /**
+   * @brief Get the interval of Val right before the instruction At.
+   *
+   * @return The interval of Val, which is empty if At is unreachable.
+   */
+  Interval getInterval(Instruction *At, Value *Val) const;
+
+private:
+  struct BlockTransfer {
+    const IntervalAnalysis *Analysis;
+    void operator()(BasicBlock *BB, IntervalMemory &State) const {
+      Analysis->transferBlock(BB, State, nullptr);
+    }
+  };
+
+  const ValueNumbering &VN;
+  MonotoneSolver<IntervalMemory, Forward, BlockTransfer, RPOWorkList,
+                 IntervalTraits>
+      Solver;
+
+  /**
+   * @brief Apply the refinement of the branch into BB, then the transfer
+   * function of every instruction of BB up to, but excluding, Stop.
+   */
+  void transferBlock(BasicBlock *BB, IntervalMemory &State,
+                     Instruction *Stop) const;
+  void transfer(Instruction *Inst, IntervalMemory &State) const;
+  void refine(BasicBlock *BB, IntervalMemory &State) const;
+  Interval eval(Value *Val, const IntervalMemory &State) const;
+};
+
+} // namespace dataflow
+
+#endif // INTERVAL_ANALYSIS_H
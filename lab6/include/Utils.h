@@ -15,6 +15,12 @@ namespace dataflow {
  */
 std::string variable(const Value *Val);
 
+/**
+ * @brief Same as variable(Val), but reuses the slot numbering of MST instead
+ * of numbering the whole module again on every call.
+ */
+std::string variable(const Value *Val, ModuleSlotTracker &MST);
+
 /**
  * @brief Try to extract Domain of a value.
  *
@@ -31,12 +37,14 @@ Domain::Element extractFromValue(const Value *Val);
  *
  * @param Mem Memory containing domain of Val.
  * @param Val Value whose domain is to be extracted from Mem.
- * @return Domain* Domain of Val in Mem.
+ * @param VN Numbering of the variables of the function.
+ * @return Domain Domain of Val in Mem.
  */
-Domain *getOrExtract(const Memory *Mem, const Value *Val);
+Domain getOrExtract(const Memory *Mem, const Value *Val,
+                    const ValueNumbering &VN);
 
 /**
- * @brief Print Memorm Mem in a human readable format to stderr.
+ * @brief Print Memorm Mem in a human readable format to O.
  *
  * Format:
  *   [ <variable1> |-> <domain1> ]
@@ -44,8 +52,11 @@ Domain *getOrExtract(const Memory *Mem, const Value *Val);
  *  ...
  *
  * @param Mem Memory to print.
+ * @param VN Numbering of the variables of the function.
+ * @param O Stream to print to.
  */
-void printMemory(const Memory *Mem);
+void printMemory(const Memory *Mem, const ValueNumbering &VN,
+                 raw_ostream &O = errs());
 
 /**
  * @brief Print Before and After domains of an instruction
@@ -57,13 +68,15 @@ void printMemory(const Memory *Mem);
  * @param Inst Instruction to print domains for.
  * @param InMem Incoming memorys.
  * @param OutMem Outgoing memory.
+ * @param VN Numbering of the variables of the function.
+ * @param O Stream to print to.
  */
 void printInstructionTransfer(Instruction *Inst, const Memory *InMem,
-                              const Memory *OutMem);
+                              const Memory *OutMem, const ValueNumbering &VN,
+                              raw_ostream &O = errs());
 
 /**
- * @brief Print In and Out memory of every instruction in function F to
- * stderr.
+ * @brief Print In and Out memory of every instruction in function F to O.
  *
  * This gives human-readable representaion of results of dataflow
  * analysis.
@@ -71,9 +84,14 @@ void printInstructionTransfer(Instruction *Inst, const Memory *InMem,
  * @param F Function whose dataflow analysis result to print.
  * @param InMap Map of In memory of every instruction in function F.
  * @param OutMap Map of Out memory of every instruction in function F.
+ * @param VN Numbering of the variables of the function.
+ * @param O Stream to print to.
+ * @param MST If given, slot numbering used to print the instructions.
  */
-void printMap(Function &F, ValueMap<Instruction *, Memory *> &InMap,
-              ValueMap<Instruction *, Memory *> &OutMap);
+void printMap(Function &F, DenseMap<Instruction *, Memory *> &InMap,
+              DenseMap<Instruction *, Memory *> &OutMap,
+              const ValueNumbering &VN, raw_ostream &O = errs(),
+              ModuleSlotTracker *MST = nullptr);
 
 } // namespace dataflow
 
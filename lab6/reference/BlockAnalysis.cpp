@@ -0,0 +1,56 @@
+/**
+ * @file BlockAnalysis.cpp
+ * @brief Block-level solver of the reference library.
+ */
+
+#include "DivZeroAnalysis.h"
+#include "MonotoneSolver.h"
+#include "Utils.h"
+
+namespace dataflow {
+
+void DivZeroAnalysis::transferBlock(BasicBlock *BB, Memory &State,
+                                    bool Record) {
+  for (Instruction &Inst : *BB) {
+    Memory Out(State);
+    transfer(&Inst, &State, Out);
+    if (Record) {
+      InMap[&Inst] = new Memory(State);
+      OutMap[&Inst] = new Memory(Out);
+    }
+    State = std::move(Out);
+  }
+}
+
+void DivZeroAnalysis::materialize(BasicBlock *BB) {
+  // Unreachable blocks have no entry state and start from an empty Memory.
+  auto It = BlockIn.find(BB);
+  Memory State = It == BlockIn.end() ? Memory() : It->second;
+  transferBlock(BB, State, true);
+}
+
+/**
+ * @brief Block-level counterpart of doAnalysis.
+ *
+ * Instead of a Memory per instruction, only the Memory at the entry and exit
+ * of each basic block is kept; the instructions of a block are evaluated in
+ * order with transferBlock(). MonotoneSolver visits blocks in reverse
+ * postorder, so a block is normally evaluated after all of its forward
+ * predecessors and each loop is iterated as a whole.
+ *
+ * @param F Function to be analyzed.
+ */
+void DivZeroAnalysis::doBlockAnalysis(Function &F) {
+  auto Transfer = [this](BasicBlock *BB, Memory &State) {
+    transferBlock(BB, State, false);
+  };
+  MonotoneSolver<Memory, Forward, decltype(Transfer)> Solver(F, Transfer);
+  Solver.solve();
+
+  for (BasicBlock &BB : F) {
+    if (const Memory *In = Solver.getIn(&BB))
+      BlockIn[&BB] = *In;
+  }
+}
+
+} // namespace dataflow
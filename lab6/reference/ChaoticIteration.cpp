@@ -0,0 +1,85 @@
+/**
+ * @file ChaoticIteration.cpp
+ * @brief Reference solution of the Chaotic Iteration Algorithm.
+ *
+ * Built into libHiddenAnalysis.a, which replaces src/ChaoticIteration.cpp
+ * when the pass is configured with -DUSE_REFERENCE=ON.
+ */
+
+#include "DivZeroAnalysis.h"
+#include "Utils.h"
+
+namespace dataflow {
+
+std::vector<Instruction *> getPredecessors(Instruction *Inst) {
+  std::vector<Instruction *> Ret;
+  if (auto Prev = Inst->getPrevNode()) {
+    Ret.push_back(Prev);
+    return Ret;
+  }
+  for (auto Pred : predecessors(Inst->getParent())) {
+    Ret.push_back(Pred->getTerminator());
+  }
+  return Ret;
+}
+
+std::vector<Instruction *> getSuccessors(Instruction *Inst) {
+  std::vector<Instruction *> Ret;
+  if (auto Next = Inst->getNextNode()) {
+    Ret.push_back(Next);
+    return Ret;
+  }
+  for (auto Succ : successors(Inst->getParent())) {
+    Ret.push_back(&Succ->front());
+  }
+  return Ret;
+}
+
+Memory *join(Memory *Mem1, Memory *Mem2) {
+  Memory *Result = new Memory(*Mem1);
+  Result->join(*Mem2);
+  return Result;
+}
+
+void DivZeroAnalysis::flowIn(Instruction *Inst, Memory *InMem) {
+  for (auto Pred : getPredecessors(Inst)) {
+    InMem->join(*OutMap[Pred]);
+  }
+}
+
+bool equal(Memory *Mem1, Memory *Mem2) { return *Mem1 == *Mem2; }
+
+void DivZeroAnalysis::flowOut(Instruction *Inst, Memory *Pre, Memory *Post,
+                              SetVector<Instruction *> &WorkSet) {
+  Memory *Joined = join(Pre, Post);
+  Memory *Out = OutMap[Inst];
+  if (!equal(Joined, Out)) {
+    *Out = std::move(*Joined);
+    for (auto Succ : getSuccessors(Inst)) {
+      WorkSet.insert(Succ);
+    }
+  }
+  delete Joined;
+}
+
+void DivZeroAnalysis::doAnalysis(Function &F) {
+  SetVector<Instruction *> WorkSet;
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+       ++Iter) {
+    WorkSet.insert(&(*Iter));
+  }
+
+  while (!WorkSet.empty()) {
+    Instruction *Inst = WorkSet.front();
+    WorkSet.remove(Inst);
+
+    Memory *In = InMap[Inst];
+    flowIn(Inst, In);
+
+    Memory Out(*In);
+    transfer(Inst, In, Out);
+    flowOut(Inst, OutMap[Inst], &Out, WorkSet);
+  }
+}
+
+} // namespace dataflow
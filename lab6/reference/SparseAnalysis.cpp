@@ -0,0 +1,133 @@
+/**
+ * @file SparseAnalysis.cpp
+ * @brief Sparse, SSA-based solver of the reference library.
+ */
+
+#include "DivZeroAnalysis.h"
+#include "Utils.h"
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SmallVector.h"
+
+namespace dataflow {
+
+/**
+ * @brief Sparse counterpart of doAnalysis.
+ *
+ * After mem2reg every fact of the analysis is about an SSA value, and an SSA
+ * value has the same Domain wherever it is used. So instead of a Memory per
+ * program point, this keeps one Domain per value in a single Memory and
+ * propagates changes along def-use chains, in the style of sparse
+ * conditional constant propagation:
+ *
+ *   + A block is only evaluated once an edge into it is known to be
+ *     executable, starting from the entry block.
+ *   + A PHINode only joins the incoming values of executable edges.
+ *   + A conditional branch whose condition is Zero or NonZero only takes the
+ *     false or true edge; an Uninit or MaybeZero condition takes both.
+ *   + When the Domain of a value changes, its users are evaluated again.
+ *
+ * Memory use is O(#values) instead of O(#instructions x #values): the In and
+ * Out Memory of every executable instruction is SparseState, and that of
+ * every unreachable instruction is the empty UnreachableState.
+ *
+ * @param F Function to be analyzed.
+ */
+void DivZeroAnalysis::doSparseAnalysis(Function &F) {
+  Memory &State = SparseState;
+
+  // transfer() writes the Domain of the instruction into this memory, from
+  // which it is read back and cleared after every call.
+  Memory Scratch;
+
+  DenseSet<BasicBlock *> Executable;
+  DenseSet<std::pair<BasicBlock *, BasicBlock *>> ExecutableEdges;
+  SmallVector<BasicBlock *, 16> BlockWorkList;
+  SmallVector<Instruction *, 64> SSAWorkList;
+
+  auto MarkEdge = [&](BasicBlock *From, BasicBlock *To) {
+    if (!ExecutableEdges.insert({From, To}).second)
+      return;
+    if (Executable.insert(To).second) {
+      BlockWorkList.push_back(To);
+    } else {
+      // A new incoming edge can only change the PHINodes of a block that is
+      // already executable.
+      for (PHINode &Phi : To->phis())
+        SSAWorkList.push_back(&Phi);
+    }
+  };
+
+  auto Visit = [&](Instruction *Inst) {
+    BasicBlock *BB = Inst->getParent();
+
+    if (auto Branch = dyn_cast<BranchInst>(Inst)) {
+      if (Branch->isConditional()) {
+        Domain Cond = getOrExtract(&State, Branch->getCondition(), *Numbering);
+        if (Cond.Value != Domain::NonZero)
+          MarkEdge(BB, Branch->getSuccessor(1));
+        if (Cond.Value != Domain::Zero)
+          MarkEdge(BB, Branch->getSuccessor(0));
+        return;
+      }
+    }
+    if (Inst->isTerminator()) {
+      for (auto Succ : successors(BB))
+        MarkEdge(BB, Succ);
+      return;
+    }
+
+    unsigned N = Numbering->lookup(Inst);
+    if (N == ValueNumbering::None)
+      return;
+
+    Domain D;
+    if (auto Phi = dyn_cast<PHINode>(Inst)) {
+      for (unsigned I = 0, E = Phi->getNumIncomingValues(); I < E; ++I) {
+        if (ExecutableEdges.count({Phi->getIncomingBlock(I), BB}))
+          D = Domain::join(
+              D, getOrExtract(&State, Phi->getIncomingValue(I), *Numbering));
+      }
+    } else {
+      transfer(Inst, &State, Scratch);
+      D = Scratch.get(N);
+      Scratch.set(N, Domain(Domain::Uninit));
+    }
+
+    Domain Old = State.get(N);
+    Domain New = Domain::join(Old, D);
+    if (Domain::equal(Old, New))
+      return;
+    State.set(N, New);
+    for (auto User : Inst->users()) {
+      if (auto UserInst = dyn_cast<Instruction>(User)) {
+        if (Executable.count(UserInst->getParent()))
+          SSAWorkList.push_back(UserInst);
+      }
+    }
+  };
+
+  BasicBlock *Entry = &F.getEntryBlock();
+  Executable.insert(Entry);
+  BlockWorkList.push_back(Entry);
+
+  while (!BlockWorkList.empty() || !SSAWorkList.empty()) {
+    while (!SSAWorkList.empty()) {
+      Visit(SSAWorkList.pop_back_val());
+    }
+    while (!BlockWorkList.empty()) {
+      for (Instruction &Inst : *BlockWorkList.pop_back_val())
+        Visit(&Inst);
+    }
+  }
+
+  for (BasicBlock &BB : F) {
+    Memory *Shared = Executable.count(&BB) ? &SparseState : &UnreachableState;
+    for (Instruction &Inst : BB) {
+      InMap[&Inst] = Shared;
+      OutMap[&Inst] = Shared;
+    }
+  }
+}
+
+} // namespace dataflow
@@ -16,28 +16,17 @@ namespace dataflow {
  */
 std::vector<Instruction *> getPredecessors(Instruction *Inst) {
   std::vector<Instruction *> Ret;
-  auto Block = Inst->getParent();
 
-  // Iterate through instructions in block in reverse order to find given
-  // instruction.
-  for (auto Iter = Block->rbegin(), End = Block->rend(); Iter != End; ++Iter) {
-    if (&(*Iter) == Inst) {
-      ++Iter;
-
-      // If previous instruction exists in same block, add it to predecessors.
-      if (Iter != End) {
-        Ret.push_back(&(*Iter));
-        return Ret;
-      }
+  // If previous instruction exists in same block, it is the only predecessor.
+  if (auto Prev = Inst->getPrevNode()) {
+    Ret.push_back(Prev);
+    return Ret;
+  }
 
-      // If instruction is first in its block, get last instruction from each
-      // predecessor block.
-      for (auto Pre = pred_begin(Block), BE = pred_end(Block); Pre != BE;
-           ++Pre) {
-        Ret.push_back(&(*((*Pre)->rbegin())));
-      }
-      return Ret;
-    }
+  // If instruction is first in its block, get last instruction from each
+  // predecessor block.
+  for (auto Pred : predecessors(Inst->getParent())) {
+    Ret.push_back(Pred->getTerminator());
   }
   return Ret;
 }
@@ -50,28 +39,17 @@ std::vector<Instruction *> getPredecessors(Instruction *Inst) {
  */
 std::vector<Instruction *> getSuccessors(Instruction *Inst) {
   std::vector<Instruction *> Ret;
-  auto Block = Inst->getParent();
-
-  // Iterate through instructions in block in reverse order to find given
-  // instruction.
-  for (auto Iter = Block->begin(), End = Block->end(); Iter != End; ++Iter) {
-    if (&(*Iter) == Inst) {
-      ++Iter;
 
-      // If next instruction exists in same block, add it to successors.
-      if (Iter != End) {
-        Ret.push_back(&(*Iter));
-        return Ret;
-      }
+  // If next instruction exists in same block, it is the only successor.
+  if (auto Next = Inst->getNextNode()) {
+    Ret.push_back(Next);
+    return Ret;
+  }
 
-      // If instruction is last in its block, get first instruction from each
-      // successor block.
-      for (auto Succ = succ_begin(Block), BS = succ_end(Block); Succ != BS;
-           ++Succ) {
-        Ret.push_back(&(*((*Succ)->begin())));
-      }
-      return Ret;
-    }
+  // If instruction is last in its block, get first instruction from each
+  // successor block.
+  for (auto Succ : successors(Inst->getParent())) {
+    Ret.push_back(&Succ->front());
   }
   return Ret;
 }
@@ -88,11 +66,12 @@ Memory *join(Memory *Mem1, Memory *Mem2) {
   /**
    * TODO: Write your code that joins two memories.
    *
-   * If some instruction with domain D is either in Mem1 or Mem2, but not in
-   *   both, add it with domain D to Result.
-   * If some instruction is present in Mem1 with domain D1 and in Mem2 with
-   *   domain D2, then Domain::join D1 and D2 to find new domain D,
-   *   and add instruction I with domain D to Result.
+   * Return a new Memory in which every variable has the Domain::join of its
+   *   domains in Mem1 and Mem2. A variable missing from one memory is
+   *   Uninit there.
+   *
+   * Hint: Memory::join joins a whole memory into another, a machine word at
+   *   a time.
    */
   return NULL;
 }
@@ -126,11 +105,10 @@ bool equal(Memory *Mem1, Memory *Mem2) {
   /**
    * TODO: Write your code to implement check for equality of two memories.
    *
-   * If any instruction I is present in one of Mem1 or Mem2,
-   *   but not in both and Domain of I is not UnInit, memories are
-   *   unequal.
-   * If any instruction I is present in Mem1 with domain D1 and in Mem2
-   *   with domain D2, if D1 and D2 are unequal, then memories are unequal.
+   * Two memories are equal if every variable has equal domains in Mem1 and
+   *   Mem2. A variable missing from one memory is Uninit there.
+   *
+   * Hint: Memory::operator== compares two memories a machine word at a time.
    */
   return false;
 }
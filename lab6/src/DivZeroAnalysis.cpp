@@ -4,10 +4,67 @@
  */
 
 #include "DivZeroAnalysis.h"
+#include "IntervalAnalysis.h"
 #include "Utils.h"
 
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+
+#include <atomic>
+#include <numeric>
+
 namespace dataflow {
 
+enum class SolverKind { Instruction, Block, Sparse };
+
+// The block and sparse solvers are part of the reference library, and can
+// only be chosen if the pass is built with -DUSE_REFERENCE=ON.
+#ifdef USE_REFERENCE
+static cl::opt<SolverKind> Solver(
+    "divzero-solver", cl::desc("Fixpoint solver used by the DivZero analysis"),
+    cl::values(clEnumValN(SolverKind::Instruction, "instruction",
+                          "Chaotic iteration over instructions (doAnalysis)"),
+               clEnumValN(SolverKind::Block, "block",
+                          "Reverse-postorder worklist over basic blocks"),
+               clEnumValN(SolverKind::Sparse, "sparse",
+                          "Propagation along SSA def-use chains")),
+    cl::init(SolverKind::Instruction));
+#else
+static cl::opt<SolverKind> Solver(
+    "divzero-solver", cl::desc("Fixpoint solver used by the DivZero analysis"),
+    cl::values(clEnumValN(SolverKind::Instruction, "instruction",
+                          "Chaotic iteration over instructions (doAnalysis)")),
+    cl::init(SolverKind::Instruction));
+#endif
+
+static cl::opt<bool> UseIntervals(
+    "divzero-intervals",
+    cl::desc("Drop divisions whose divisor is proven non-zero by an interval "
+             "analysis"),
+    cl::init(false));
+
+static cl::opt<std::string> CacheDir(
+    "divzero-cache-dir",
+    cl::desc("Directory in which to cache the result of every function, so "
+             "that unchanged functions are not analyzed again"),
+    cl::init(""));
+
+/**
+ * @brief The options that change the result of the analysis, as part of the
+ * cache key.
+ */
+static std::string getCacheConfig() {
+  return "solver=" + std::to_string(static_cast<int>(Solver.getValue())) +
+         " intervals=" + std::to_string(UseIntervals.getValue());
+}
+
+static cl::opt<unsigned> Threads(
+    "divzero-threads",
+    cl::desc("Number of threads used by the DivZero module pass (0 = all "
+             "hardware threads)"),
+    cl::init(0));
+
 //===----------------------------------------------------------------------===//
 // DivZero Analysis Implementation
 //===----------------------------------------------------------------------===//
@@ -45,39 +102,140 @@ bool DivZeroAnalysis::check(Instruction *Inst) {
  * @param F Function on which to perform dataflow analysis.
  */
 bool DivZeroAnalysis::runOnFunction(Function &F) {
-  outs() << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+  raw_ostream &OS = *ResultStream;
+  OS << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+  Numbering = new ValueNumbering(F);
+  Numbering->setSlotTracker(SlotTracker);
 
-  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
-       ++Iter) {
-    auto Inst = &(*Iter);
-    InMap[Inst] = new Memory;
-    OutMap[Inst] = new Memory;
+  std::string CacheKey;
+  bool Cached = false;
+  if (!CacheDir.empty()) {
+    AnalysisCache Cache(CacheDir);
+    CacheKey = Cache.getKey(F, getCacheConfig());
+    Cached = loadCachedResult(F, Cache, CacheKey);
   }
 
-  doAnalysis(F);
+  if (Cached) {
+    // The fixpoint and the checks below are replaced by the cached result.
+  } else if (Solver == SolverKind::Instruction) {
+    for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+         ++Iter) {
+      auto Inst = &(*Iter);
+      InMap[Inst] = new Memory;
+      OutMap[Inst] = new Memory;
+    }
 
-  // Check each instruction in function F for potential divide-by-zero error.
-  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
-       ++Iter) {
-    auto Inst = &(*Iter);
-    if (check(Inst))
-      ErrorInsts.insert(Inst);
+    doAnalysis(F);
+#ifdef USE_REFERENCE
+  } else if (Solver == SolverKind::Sparse) {
+    doSparseAnalysis(F);
+  } else {
+    // The fixpoint only tracks block states; the memory of each instruction
+    // is rebuilt once afterwards, for check() and printMap().
+    doBlockAnalysis(F);
+    for (BasicBlock &BB : F)
+      materialize(&BB);
+#endif
+  }
+
+  if (!Cached) {
+    // Check each instruction in function F for potential divide-by-zero
+    // error.
+    for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+         ++Iter) {
+      auto Inst = &(*Iter);
+      if (check(Inst))
+        ErrorInsts.insert(Inst);
+    }
+
+    // Intervals can prove that e.g. a loop counter is never zero, which
+    // Domain cannot, but they cost more to compute and are opt-in.
+    if (UseIntervals && !ErrorInsts.empty()) {
+      IntervalAnalysis Intervals(F, *Numbering);
+      ErrorInsts.remove_if([&Intervals](Instruction *Inst) {
+        Value *Divisor = Inst->getOperand(1);
+        return Divisor->getType()->isIntegerTy() &&
+               !Intervals.getInterval(Inst, Divisor).contains(0);
+      });
+    }
+
+    if (!CacheDir.empty())
+      storeCachedResult(F, AnalysisCache(CacheDir), CacheKey);
   }
 
-  printMap(F, InMap, OutMap);
-  outs() << "Potential Instructions by " << getAnalysisName() << ": \n";
+  printMap(F, InMap, OutMap, *Numbering, *MapStream, SlotTracker);
+  OS << "Potential Instructions by " << getAnalysisName() << ": \n";
   for (auto Inst : ErrorInsts) {
-    outs() << *Inst << "\n";
+    if (SlotTracker)
+      Inst->print(OS, *SlotTracker);
+    else
+      OS << *Inst;
+    OS << "\n";
   }
 
+  // The memories of the sparse solver are shared, not owned by the maps.
+  if (Solver == SolverKind::Sparse && !Cached) {
+    InMap.clear();
+    OutMap.clear();
+    SparseState = Memory();
+  }
   for (auto Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
     delete InMap[&(*Iter)];
     delete OutMap[&(*Iter)];
   }
+  delete Numbering;
+  Numbering = nullptr;
+  BlockIn.clear();
 
   return false;
 }
 
+bool DivZeroAnalysis::loadCachedResult(Function &F, const AnalysisCache &Cache,
+                                       StringRef Key) {
+  CachedResult Result;
+  if (!Cache.load(Key, Result))
+    return false;
+
+  std::vector<Instruction *> Insts;
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+       ++Iter) {
+    Insts.push_back(&(*Iter));
+  }
+  if (Result.In.size() != Insts.size())
+    return false;
+  for (unsigned Index : Result.ErrorInsts) {
+    if (Index >= Insts.size())
+      return false;
+  }
+
+  for (unsigned I = 0, E = Insts.size(); I < E; ++I) {
+    InMap[Insts[I]] = new Memory(std::move(Result.In[I]));
+    OutMap[Insts[I]] = new Memory(std::move(Result.Out[I]));
+  }
+  for (unsigned Index : Result.ErrorInsts) {
+    ErrorInsts.insert(Insts[Index]);
+  }
+  return true;
+}
+
+void DivZeroAnalysis::storeCachedResult(Function &F,
+                                        const AnalysisCache &Cache,
+                                        StringRef Key) {
+  CachedResult Result;
+  DenseMap<Instruction *, unsigned> Index;
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+       ++Iter) {
+    auto Inst = &(*Iter);
+    Index[Inst] = Result.In.size();
+    Result.In.push_back(*InMap[Inst]);
+    Result.Out.push_back(*OutMap[Inst]);
+  }
+  for (auto Inst : ErrorInsts) {
+    Result.ErrorInsts.push_back(Index[Inst]);
+  }
+  Cache.store(Key, Result);
+}
+
 char DivZeroAnalysis::ID = 1;
 // static RegisterPass<DivZeroAnalysis> X("DivZero", "Divide-by-zero Analysis",
 //                                        false, false);
@@ -90,6 +248,72 @@ struct DivZeroAnalysisNPMWrapper : public PassInfoMixin<DivZeroAnalysisNPMWrappe
   }
 };
 
+/**
+ * Module-level driver: analyses all defined functions on a thread pool.
+ * Every function gets its own DivZeroAnalysis and output buffers, which are
+ * printed in module order once all functions are done, so the output does
+ * not depend on scheduling.
+ */
+struct DivZeroModulePass : public PassInfoMixin<DivZeroModulePass> {
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &) {
+    struct Report {
+      std::string Results;
+      std::string Map;
+    };
+
+    std::vector<Function *> Functions;
+    for (Function &F : M) {
+      if (!F.isDeclaration())
+        Functions.push_back(&F);
+    }
+    std::vector<Report> Reports(Functions.size());
+
+    // Largest functions first, so that no worker picks up a big function
+    // while all the others have run out of work.
+    std::vector<size_t> Schedule(Functions.size());
+    std::iota(Schedule.begin(), Schedule.end(), 0);
+    std::stable_sort(Schedule.begin(), Schedule.end(),
+                     [&Functions](size_t A, size_t B) {
+                       return Functions[A]->getInstructionCount() >
+                              Functions[B]->getInstructionCount();
+                     });
+
+    {
+      // One task per worker, each pulling functions from a shared counter.
+      // Every worker numbers the module's slots once in its own tracker,
+      // rather than once per printed instruction.
+      ThreadPoolStrategy Strategy = hardware_concurrency(Threads);
+      size_t NumWorkers =
+          std::min<size_t>(Strategy.compute_thread_count(), Functions.size());
+      std::atomic<size_t> Next(0);
+
+      DefaultThreadPool Pool(Strategy);
+      for (size_t W = 0; W < NumWorkers; ++W) {
+        Pool.async([&] {
+          ModuleSlotTracker MST(&M);
+          for (size_t I = Next++; I < Schedule.size(); I = Next++) {
+            Report &R = Reports[Schedule[I]];
+            raw_string_ostream Results(R.Results);
+            raw_string_ostream Map(R.Map);
+            DivZeroAnalysis P;
+            P.ResultStream = &Results;
+            P.MapStream = &Map;
+            P.SlotTracker = &MST;
+            P.runOnFunction(*Functions[Schedule[I]]);
+          }
+        });
+      }
+      Pool.wait();
+    }
+
+    for (const Report &R : Reports) {
+      outs() << R.Results;
+      errs() << R.Map;
+    }
+    return PreservedAnalyses::all();
+  }
+};
+
 const auto PASS_NAME = "DivZeroPass";
 
 extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
@@ -107,6 +331,15 @@ extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
               }
               return false;
             });
+        PB.registerPipelineParsingCallback(
+            [](StringRef Name, ModulePassManager& MPM,
+               ArrayRef<PassBuilder::PipelineElement>) {
+              if (Name == "DivZero-module") {
+                MPM.addPass(DivZeroModulePass());
+                return true;
+              }
+              return false;
+            });
         PB.registerPipelineStartEPCallback(
             [](ModulePassManager& MPM, OptimizationLevel) {
               MPM.addPass(
@@ -0,0 +1,327 @@
+/**
+ * @file IntervalAnalysis.cpp
+ * @brief Interval analysis with threshold widening and narrowing.
+ */
+
+#include "IntervalAnalysis.h"
+
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+
+namespace dataflow {
+
+/**
+ * @brief Widening thresholds of F: every constant an icmp compares against
+ * and its neighbours, plus the bounds of the common integer types.
+ */
+static IntervalTraits collectThresholds(Function &F) {
+  IntervalTraits Traits;
+  std::vector<int64_t> &T = Traits.Thresholds;
+  T.push_back(-1);
+  T.push_back(0);
+  T.push_back(1);
+  for (unsigned Bits : {8u, 16u, 32u}) {
+    T.push_back(Interval::top(Bits).Lo);
+    T.push_back(Interval::top(Bits).Hi);
+  }
+  for (Instruction &Inst : instructions(F)) {
+    if (!isa<ICmpInst>(Inst))
+      continue;
+    for (Value *Op : Inst.operands()) {
+      auto C = dyn_cast<ConstantInt>(Op);
+      if (!C || C->getBitWidth() > Interval::MaxBits)
+        continue;
+      int64_t V = C->getSExtValue();
+      T.push_back(V - 1);
+      T.push_back(V);
+      T.push_back(V + 1);
+    }
+  }
+  std::sort(T.begin(), T.end());
+  T.erase(std::unique(T.begin(), T.end()), T.end());
+  return Traits;
+}
+
+static unsigned getBits(const Value *Val) {
+  return cast<IntegerType>(Val->getType())->getBitWidth();
+}
+
+/**
+ * @brief Are both bounds of I values of a Bits-wide integer we track?
+ */
+static bool inRange(const Interval &I, unsigned Bits) {
+  return Bits <= Interval::MaxBits && Interval::top(Bits).contains(I.Lo) &&
+         Interval::top(Bits).contains(I.Hi);
+}
+
+/**
+ * @brief The result of an operation on Bits-wide integers: it wraps around
+ * if it does not fit, so it can be anything.
+ */
+static Interval fit(const Interval &I, unsigned Bits) {
+  if (I.isEmpty() || inRange(I, Bits))
+    return I;
+  return Interval::top(Bits);
+}
+
+static Interval fromCorners(int64_t A, int64_t B, int64_t C, int64_t D) {
+  return Interval(std::min(std::min(A, B), std::min(C, D)),
+                  std::max(std::max(A, B), std::max(C, D)));
+}
+
+/**
+ * @brief Signed division, skipping a zero divisor since it is undefined.
+ */
+static Interval divide(const Interval &A, const Interval &B) {
+  Interval Result;
+  int64_t Min = std::numeric_limits<int64_t>::min();
+  int64_t Max = std::numeric_limits<int64_t>::max();
+  for (const Interval &Part :
+       {Interval::meet(B, Interval(Min, -1)), Interval::meet(B, Interval(1, Max))}) {
+    if (Part.isEmpty())
+      continue;
+    Result = Interval::join(
+        Result, fromCorners(A.Lo / Part.Lo, A.Lo / Part.Hi, A.Hi / Part.Lo,
+                            A.Hi / Part.Hi));
+  }
+  return Result;
+}
+
+/**
+ * @brief Signed remainder, whose sign is that of the dividend and whose
+ * magnitude is less than that of the divisor.
+ */
+static Interval remainder(const Interval &A, const Interval &B) {
+  int64_t M = std::max(std::abs(B.Lo), std::abs(B.Hi)) - 1;
+  if (M < 0)
+    return Interval::bottom();
+  Interval Result(A.Lo >= 0 ? 0 : -M, A.Hi <= 0 ? 0 : M);
+  return Interval::meet(
+      Result, Interval(std::min(A.Lo, int64_t(0)), std::max(A.Hi, int64_t(0))));
+}
+
+static Interval evalBinary(Instruction::BinaryOps Op, const Interval &A,
+                           const Interval &B, unsigned Bits) {
+  if (A.isEmpty() || B.isEmpty())
+    return Interval::bottom();
+  if (!inRange(A, Bits) || !inRange(B, Bits))
+    return Interval::top(Bits);
+
+  switch (Op) {
+  case Instruction::Add:
+    return Interval(A.Lo + B.Lo, A.Hi + B.Hi);
+  case Instruction::Sub:
+    return Interval(A.Lo - B.Hi, A.Hi - B.Lo);
+  case Instruction::Mul:
+    return fromCorners(A.Lo * B.Lo, A.Lo * B.Hi, A.Hi * B.Lo, A.Hi * B.Hi);
+  case Instruction::SDiv:
+    return divide(A, B);
+  case Instruction::SRem:
+    return remainder(A, B);
+  case Instruction::UDiv:
+    // Non-negative operands have the same signed and unsigned value.
+    if (A.Lo >= 0 && B.Lo >= 0)
+      return divide(A, B);
+    return Interval::top(Bits);
+  case Instruction::URem:
+    if (A.Lo >= 0 && B.Lo >= 0)
+      return remainder(A, B);
+    return Interval::top(Bits);
+  default:
+    return Interval::top(Bits);
+  }
+}
+
+IntervalAnalysis::IntervalAnalysis(Function &F, const ValueNumbering &VN)
+    : VN(VN), Solver(F, BlockTransfer{this}, collectThresholds(F)) {
+  // Arguments of the function can hold any value.
+  IntervalMemory Entry;
+  for (Argument &Arg : F.args()) {
+    if (Arg.getType()->isIntegerTy())
+      Entry.set(VN.lookup(&Arg), Interval::top(getBits(&Arg)));
+  }
+  Solver.setBoundary(Entry);
+
+  DominatorTree DT(F);
+  LoopInfo LI(DT);
+  std::vector<BasicBlock *> Heads;
+  for (Loop *L : LI.getLoopsInPreorder()) {
+    Heads.push_back(L->getHeader());
+  }
+  // LoopInfo only knows natural loops. The target of any other retreating
+  // edge, which only exists in irreducible control flow, is widened too so
+  // that every cycle goes through a widening point.
+  ReversePostOrderTraversal<Function *> RPOT(&F);
+  DenseMap<BasicBlock *, unsigned> Order;
+  for (BasicBlock *BB : RPOT) {
+    unsigned I = Order.size();
+    Order[BB] = I;
+  }
+  for (BasicBlock *BB : RPOT) {
+    if (LI.isLoopHeader(BB))
+      continue;
+    for (auto Pred : predecessors(BB)) {
+      auto It = Order.find(Pred);
+      if (It != Order.end() && It->second >= Order[BB]) {
+        Heads.push_back(BB);
+        break;
+      }
+    }
+  }
+  Solver.setLoopHeads(Heads);
+
+  Solver.solve();
+  Solver.narrow(NarrowingRounds);
+}
+
+Interval IntervalAnalysis::getInterval(Instruction *At, Value *Val) const {
+  const IntervalMemory *In = Solver.getIn(At->getParent());
+  if (!In)
+    return Interval::bottom();
+  IntervalMemory State(*In);
+  transferBlock(At->getParent(), State, At);
+  return eval(Val, State);
+}
+
+void IntervalAnalysis::transferBlock(BasicBlock *BB, IntervalMemory &State,
+                                     Instruction *Stop) const {
+  refine(BB, State);
+  for (Instruction &Inst : *BB) {
+    if (&Inst == Stop)
+      return;
+    transfer(&Inst, State);
+  }
+}
+
+Interval IntervalAnalysis::eval(Value *Val,
+                                const IntervalMemory &State) const {
+  unsigned Bits = getBits(Val);
+  if (auto C = dyn_cast<ConstantInt>(Val)) {
+    if (Bits > Interval::MaxBits)
+      return Interval::top(Bits);
+    return Interval::constant(C->getSExtValue());
+  }
+  unsigned N = VN.lookup(Val);
+  if (N == ValueNumbering::None)
+    return Interval::top(Bits);
+  return State.get(N);
+}
+
+void IntervalAnalysis::transfer(Instruction *Inst,
+                                IntervalMemory &State) const {
+  if (!Inst->getType()->isIntegerTy())
+    return;
+  unsigned Bits = getBits(Inst);
+
+  Interval Result = Interval::top(Bits);
+  if (Bits == 1 || Bits > Interval::MaxBits) {
+    // Booleans and wide integers are not tracked.
+  } else if (auto BinOp = dyn_cast<BinaryOperator>(Inst)) {
+    Result = evalBinary(BinOp->getOpcode(), eval(BinOp->getOperand(0), State),
+                        eval(BinOp->getOperand(1), State), Bits);
+  } else if (auto Cast = dyn_cast<CastInst>(Inst)) {
+    Value *Src = Cast->getOperand(0);
+    if (Src->getType()->isIntegerTy()) {
+      Interval A = eval(Src, State);
+      unsigned SrcBits = getBits(Src);
+      if (A.isEmpty())
+        Result = A;
+      else if (Cast->getOpcode() == Instruction::ZExt && A.Lo < 0)
+        Result = SrcBits < Interval::MaxBits
+                     ? Interval(0, (int64_t(1) << SrcBits) - 1)
+                     : Interval::top(Bits);
+      else if (Cast->getOpcode() == Instruction::SExt ||
+               Cast->getOpcode() == Instruction::ZExt ||
+               Cast->getOpcode() == Instruction::Trunc)
+        Result = inRange(A, SrcBits) ? A : Interval::top(Bits);
+    }
+  } else if (auto Phi = dyn_cast<PHINode>(Inst)) {
+    Result = Interval::bottom();
+    for (Value *Incoming : Phi->incoming_values()) {
+      Result = Interval::join(Result, eval(Incoming, State));
+    }
+  } else if (auto Select = dyn_cast<SelectInst>(Inst)) {
+    Result = Interval::join(eval(Select->getTrueValue(), State),
+                            eval(Select->getFalseValue(), State));
+  }
+  State.set(VN.lookup(Inst), fit(Result, Bits));
+}
+
+/**
+ * @brief Bound Cur knowing that `Cur Pred Other` holds.
+ */
+static Interval restrict(const Interval &Cur, CmpInst::Predicate Pred,
+                         const Interval &Other) {
+  int64_t Min = std::numeric_limits<int64_t>::min();
+  int64_t Max = std::numeric_limits<int64_t>::max();
+  switch (Pred) {
+  case CmpInst::ICMP_EQ:
+    return Interval::meet(Cur, Other);
+  case CmpInst::ICMP_NE:
+    if (Other.Lo == Other.Hi && Cur.Lo == Other.Lo)
+      return Interval(Cur.Lo + 1, Cur.Hi);
+    if (Other.Lo == Other.Hi && Cur.Hi == Other.Hi)
+      return Interval(Cur.Lo, Cur.Hi - 1);
+    return Cur;
+  case CmpInst::ICMP_SLT:
+    return Interval::meet(Cur, Interval(Min, Other.Hi - 1));
+  case CmpInst::ICMP_SLE:
+    return Interval::meet(Cur, Interval(Min, Other.Hi));
+  case CmpInst::ICMP_SGT:
+    return Interval::meet(Cur, Interval(Other.Lo + 1, Max));
+  case CmpInst::ICMP_SGE:
+    return Interval::meet(Cur, Interval(Other.Lo, Max));
+  // Unsigned comparisons only say something about the signed value when both
+  // sides are known to be non-negative, or when the larger side is.
+  case CmpInst::ICMP_ULT:
+    if (Other.Lo >= 0)
+      return Interval::meet(Cur, Interval(0, Other.Hi - 1));
+    return Cur;
+  case CmpInst::ICMP_ULE:
+    if (Other.Lo >= 0)
+      return Interval::meet(Cur, Interval(0, Other.Hi));
+    return Cur;
+  case CmpInst::ICMP_UGT:
+    if (Cur.Lo >= 0 && Other.Lo >= 0)
+      return Interval::meet(Cur, Interval(Other.Lo + 1, Max));
+    return Cur;
+  case CmpInst::ICMP_UGE:
+    if (Cur.Lo >= 0 && Other.Lo >= 0)
+      return Interval::meet(Cur, Interval(Other.Lo, Max));
+    return Cur;
+  default:
+    return Cur;
+  }
+}
+
+void IntervalAnalysis::refine(BasicBlock *BB, IntervalMemory &State) const {
+  BasicBlock *Pred = BB->getSinglePredecessor();
+  if (!Pred)
+    return;
+  auto Branch = dyn_cast<BranchInst>(Pred->getTerminator());
+  if (!Branch || !Branch->isConditional() ||
+      Branch->getSuccessor(0) == Branch->getSuccessor(1))
+    return;
+  auto Cmp = dyn_cast<ICmpInst>(Branch->getCondition());
+  if (!Cmp || !Cmp->getOperand(0)->getType()->isIntegerTy() ||
+      getBits(Cmp->getOperand(0)) > Interval::MaxBits)
+    return;
+
+  CmpInst::Predicate P = Branch->getSuccessor(0) == BB
+                             ? Cmp->getPredicate()
+                             : Cmp->getInversePredicate();
+  Value *LHS = Cmp->getOperand(0);
+  Value *RHS = Cmp->getOperand(1);
+  Interval L = eval(LHS, State);
+  Interval R = eval(RHS, State);
+  if (L.isEmpty() || R.isEmpty())
+    return;
+  State.set(VN.lookup(LHS), restrict(L, P, R));
+  State.set(VN.lookup(RHS), restrict(R, CmpInst::getSwappedPredicate(P), L));
+}
+
+} // namespace dataflow
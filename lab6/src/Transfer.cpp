@@ -29,17 +29,19 @@ bool isInput(Instruction *Inst) {
  *
  * @param Phi PHINode to evaluate.
  * @param InMem InMemory of PHINode.
+ * @param VN Numbering of the variables of the function.
  * @return Domain of PHINode.
  */
-Domain *eval(PHINode *Phi, const Memory *InMem) {
+Domain eval(PHINode *Phi, const Memory *InMem,
+            const ValueNumbering &VN) {
   if (auto ConstantVal = Phi->hasConstantValue()) {
-    return new Domain(extractFromValue(ConstantVal));
+    return Domain(extractFromValue(ConstantVal));
   }
 
-  Domain *Joined = new Domain(Domain::Uninit);
+  Domain Joined(Domain::Uninit);
 
   for (unsigned int i = 0; i < Phi->getNumIncomingValues(); i++) {
-    auto Dom = getOrExtract(InMem, Phi->getIncomingValue(i));
+    auto Dom = getOrExtract(InMem, Phi->getIncomingValue(i), VN);
     Joined = Domain::join(Joined, Dom);
   }
 
@@ -52,14 +54,16 @@ Domain *eval(PHINode *Phi, const Memory *InMem) {
  *
  * @param BinOp BinaryOperator to evaluate.
  * @param InMem InMemory of BinOp.
+ * @param VN Numbering of the variables of the function.
  * @return Domain of BinOp.
  */
-Domain *eval(BinaryOperator *BinOp, const Memory *InMem) {
+Domain eval(BinaryOperator *BinOp, const Memory *InMem,
+            const ValueNumbering &VN) {
   /**
    * TODO: Write your code here that evaluates +, -, * and /
    * based on Domains of operands.
    */
-  return NULL;
+  return Domain(Domain::Uninit);
 }
 
 /**
@@ -67,13 +71,15 @@ Domain *eval(BinaryOperator *BinOp, const Memory *InMem) {
  *
  * @param Cast Cast instruction to evaluate.
  * @param InMem InMemory of Cast.
+ * @param VN Numbering of the variables of the function.
  * @return Domain of Cast.
  */
-Domain *eval(CastInst *Cast, const Memory *InMem) {
+Domain eval(CastInst *Cast, const Memory *InMem,
+            const ValueNumbering &VN) {
   /**
    * TODO: Write your code here to evaluate Cast instruction.
    */
-  return NULL;
+  return Domain(Domain::Uninit);
 }
 
 /**
@@ -82,9 +88,11 @@ Domain *eval(CastInst *Cast, const Memory *InMem) {
  *
  * @param Cmp Comparision instruction to evaluate.
  * @param InMem InMemory of Cmp.
+ * @param VN Numbering of the variables of the function.
  * @return Domain of Cmp.
  */
-Domain *eval(CmpInst *Cmp, const Memory *InMem) {
+Domain eval(CmpInst *Cmp, const Memory *InMem,
+            const ValueNumbering &VN) {
   /**
    * TODO: Write your code here that evaluates:
    * ==, !=, <, <=, >=, and > based on Domains of operands.
@@ -92,7 +100,7 @@ Domain *eval(CmpInst *Cmp, const Memory *InMem) {
    * NOTE: There is a lot of scope for refining this, but you can just return
    * MaybeZero for comparisons other than equality.
    */
-  return NULL;
+  return Domain(Domain::Uninit);
 }
 
 /**
@@ -105,15 +113,15 @@ Domain *eval(CmpInst *Cmp, const Memory *InMem) {
 void DivZeroAnalysis::transfer(Instruction *Inst, const Memory *In,
                                Memory &NOut) {
   if (isInput(Inst)) {
-    NOut[variable(Inst)] = new Domain(Domain::Element::MaybeZero);
+    NOut[Numbering->lookup(Inst)] = Domain(Domain::Element::MaybeZero);
   } else if (auto Phi = dyn_cast<PHINode>(Inst)) {
-    NOut[variable(Phi)] = eval(Phi, In);
+    NOut[Numbering->lookup(Phi)] = eval(Phi, In, *Numbering);
   } else if (auto BinOp = dyn_cast<BinaryOperator>(Inst)) {
-    NOut[variable(BinOp)] = eval(BinOp, In);
+    NOut[Numbering->lookup(BinOp)] = eval(BinOp, In, *Numbering);
   } else if (auto Cast = dyn_cast<CastInst>(Inst)) {
-    NOut[variable(Cast)] = eval(Cast, In);
+    NOut[Numbering->lookup(Cast)] = eval(Cast, In, *Numbering);
   } else if (auto Cmp = dyn_cast<CmpInst>(Inst)) {
-    NOut[variable(Cmp)] = eval(Cmp, In);
+    NOut[Numbering->lookup(Cmp)] = eval(Cmp, In, *Numbering);
   }
 }
 
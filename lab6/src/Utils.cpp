@@ -5,20 +5,9 @@
 const char *WHITESPACES = " \t\n\r";
 const size_t VARIABLE_PADDED_LEN = 8;
 
-template <typename V, typename K, class Map, class DefaultConstructor>
-V getOrDefault(const Map *M, const K &Key, DefaultConstructor Default) {
-  const auto It = M->find(Key);
-  if (It == M->end())
-    return Default();
-  return It->second;
-}
-
 namespace dataflow {
 
-std::string variable(const Value *Val) {
-  std::string Code;
-  raw_string_ostream SS(Code);
-  Val->print(SS);
+static std::string variableName(std::string Code) {
   Code.erase(0, Code.find_first_not_of(WHITESPACES));
   auto RetVal = Code.substr(0, Code.find_first_of(WHITESPACES));
   if (RetVal == "ret" || RetVal == "br" || RetVal == "store") {
@@ -33,6 +22,20 @@ std::string variable(const Value *Val) {
   return RetVal;
 }
 
+std::string variable(const Value *Val) {
+  std::string Code;
+  raw_string_ostream SS(Code);
+  Val->print(SS);
+  return variableName(SS.str());
+}
+
+std::string variable(const Value *Val, ModuleSlotTracker &MST) {
+  std::string Code;
+  raw_string_ostream SS(Code);
+  Val->print(SS, MST);
+  return variableName(SS.str());
+}
+
 Domain::Element extractFromValue(const Value *Val) {
   if (dyn_cast<UndefValue>(Val)) {
     return Domain::MaybeZero;
@@ -42,42 +45,56 @@ Domain::Element extractFromValue(const Value *Val) {
   return Domain::Uninit;
 }
 
-Domain *getOrExtract(const Memory *Mem, const Value *Val) {
-  return getOrDefault<Domain *>(Mem, variable(Val), [&V = Val] {
-    return new Domain(extractFromValue(V));
-  });
+Domain getOrExtract(const Memory *Mem, const Value *Val,
+                    const ValueNumbering &VN) {
+  unsigned N = VN.lookup(Val);
+  if (N == ValueNumbering::None) {
+    return Domain(extractFromValue(Val));
+  }
+  return Mem->get(N);
 }
 
-void printMemory(const Memory *Mem) {
-  for (auto Iter = Mem->begin(), End = Mem->end(); Iter != End; ++Iter) {
-    errs() << "    [ " << Iter->first << " |-> " << *Iter->second << " ]\n";
+void printMemory(const Memory *Mem, const ValueNumbering &VN,
+                 raw_ostream &O) {
+  for (unsigned N = 0, End = Mem->size(); N < End; ++N) {
+    Domain D = Mem->get(N);
+    if (D.Value == Domain::Uninit)
+      continue;
+    O << "    [ " << VN.getName(N) << " |-> " << D << " ]\n";
   }
   if (Mem->empty()) {
-    errs() << "\n";
+    O << "\n";
   }
 }
 
 void printInstructionTransfer(Instruction *Inst, const Memory *InMem,
-                              const Memory *OutMem) {
-  auto InState = getOrExtract(InMem, Inst);
-  auto OutState = getOrExtract(OutMem, Inst);
-  errs() << variable(Inst) << ":\t[ " << *InState << " --> " << *OutState
-         << " ]\n";
+                              const Memory *OutMem, const ValueNumbering &VN,
+                              raw_ostream &O) {
+  auto InState = getOrExtract(InMem, Inst, VN);
+  auto OutState = getOrExtract(OutMem, Inst, VN);
+  O << variable(Inst) << ":\t[ " << InState << " --> " << OutState << " ]\n";
 }
 
-void printMap(Function &F, ValueMap<Instruction *, Memory *> &InMap,
-              ValueMap<Instruction *, Memory *> &OutMap) {
-  errs() << "Dataflow Analysis Results:\n";
+void printMap(Function &F, DenseMap<Instruction *, Memory *> &InMap,
+              DenseMap<Instruction *, Memory *> &OutMap,
+              const ValueNumbering &VN, raw_ostream &O,
+              ModuleSlotTracker *MST) {
+  O << "Dataflow Analysis Results:\n";
   for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
     auto Inst = &(*Iter);
-    errs() << "Instruction: " << *Inst << "\n";
-    errs() << "In set: \n";
+    O << "Instruction: ";
+    if (MST)
+      Inst->print(O, *MST);
+    else
+      O << *Inst;
+    O << "\n";
+    O << "In set: \n";
     auto InMem = InMap[Inst];
-    printMemory(InMem);
-    errs() << "Out set: \n";
+    printMemory(InMem, VN, O);
+    O << "Out set: \n";
     auto OutMem = OutMap[Inst];
-    printMemory(OutMem);
-    errs() << "\n";
+    printMemory(OutMem, VN, O);
+    O << "\n";
   }
 }
 
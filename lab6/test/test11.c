@@ -0,0 +1,8 @@
+void f() {
+  int i;
+  int sum = 0;
+  for (i = 1; i < 100; i++) {
+    sum += 1000 / i;
+  }
+  int z = 1000 / (i - 100);
+}
@@ -0,0 +1,142 @@
+#ifndef ANALYSIS_PASSES_H
+#define ANALYSIS_PASSES_H
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/PassManager.h"
+#include <memory>
+
+#include "DivZeroAnalysis.h"
+#include "PointerAnalysis.h"
+
+using namespace llvm;
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// New Pass Manager Analyses
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief The points-to graph of a function, as an analysis of the new pass
+ * manager, so that every pass of a pipeline shares the one it caches.
+ */
+struct PointerAnalysisPass : public AnalysisInfoMixin<PointerAnalysisPass> {
+  class Result {
+  public:
+    explicit Result(std::unique_ptr<PointerAnalysis> Graph)
+        : Graph(std::move(Graph)) {}
+
+    PointerAnalysis &getGraph() const { return *Graph; }
+
+    /**
+     * @brief The graph depends on every instruction, so it is only kept if
+     * the pass preserved it, or all analyses of the function.
+     */
+    bool invalidate(Function &F, const PreservedAnalyses &PA,
+                    FunctionAnalysisManager::Invalidator &Inv);
+
+  private:
+    /// PointerAnalysis is not movable, and the result must be.
+    std::unique_ptr<PointerAnalysis> Graph;
+  };
+
+  Result run(Function &F, FunctionAnalysisManager &AM);
+
+private:
+  friend AnalysisInfoMixin<PointerAnalysisPass>;
+  static AnalysisKey Key;
+};
+
+/**
+ * @brief The DivZero results of a function, i.e. the In and Out Memory of
+ * every instruction and the divisions that may divide by zero, as an
+ * analysis of the new pass manager. It uses the cached PointerAnalysisPass,
+ * and is computed by DivZeroAnalysis::analyze(), as in the legacy pass.
+ */
+struct DivZeroAnalysisPass : public AnalysisInfoMixin<DivZeroAnalysisPass> {
+  class Result {
+  public:
+    Result(Function &F, std::unique_ptr<DivZeroAnalysis> Analysis)
+        : F(&F), Analysis(std::move(Analysis)) {}
+    Result(Result &&) = default;
+    ~Result();
+
+    const Memory *getIn(Instruction *Inst) const {
+      return Analysis->InMap.lookup(Inst);
+    }
+    const Memory *getOut(Instruction *Inst) const {
+      return Analysis->OutMap.lookup(Inst);
+    }
+    const SetVector<Instruction *> &getErrorInsts() const {
+      return Analysis->ErrorInsts;
+    }
+
+    /**
+     * @brief Get the Domain of the divisor of Div, a division, before it
+     * runs.
+     */
+    Domain getDivisor(Instruction *Div) const;
+
+    /**
+     * @brief Print the results as the legacy DivZero pass does.
+     */
+    void print() const { Analysis->printResults(*F); }
+
+    /**
+     * @brief The results are kept if the pass preserved them, or all
+     * analyses of the function, and the points-to graph was kept too.
+     */
+    bool invalidate(Function &F, const PreservedAnalyses &PA,
+                    FunctionAnalysisManager::Invalidator &Inv);
+
+  private:
+    Function *F;
+    /// Holds the results; they are freed with the Result.
+    std::unique_ptr<DivZeroAnalysis> Analysis;
+  };
+
+  Result run(Function &F, FunctionAnalysisManager &AM);
+
+private:
+  friend AnalysisInfoMixin<DivZeroAnalysisPass>;
+  static AnalysisKey Key;
+};
+
+/**
+ * @brief Print the points-to graph and the DivZero results of a function,
+ * like the legacy DivZero pass, from the cached analyses.
+ */
+struct DivZeroPrinterPass : public PassInfoMixin<DivZeroPrinterPass> {
+  PreservedAnalyses run(Function &F, FunctionAnalysisManager &AM);
+};
+
+/**
+ * @brief Mark every division whose divisor the cached DivZero results prove
+ * NonZero with the SafeDivisionMD metadata, so that later tools, e.g. the
+ * instrumentation of lab3, can skip it. The module gets the AnnotatedFlag
+ * module flag, which tells these tools that the metadata was computed on
+ * this very IR, and not left over from, or pasted into, another input.
+ *
+ * It is a module pass, since it changes the module as well as the functions.
+ */
+struct DivZeroAnnotatePass : public PassInfoMixin<DivZeroAnnotatePass> {
+  /// Name of the metadata kind of safe divisions.
+  static const char *SafeDivisionMD;
+  /// Name of the module flag of annotated modules.
+  static const char *AnnotatedFlag;
+
+  PreservedAnalyses run(Module &M, ModuleAnalysisManager &AM);
+
+private:
+  /**
+   * @brief Annotate the safe divisions of F.
+   *
+   * @return true if a division was annotated.
+   */
+  bool annotate(Function &F, FunctionAnalysisManager &AM);
+};
+
+} // namespace dataflow
+
+#endif // ANALYSIS_PASSES_H
@@ -0,0 +1,165 @@
+#ifndef CONSTRAINT_SOLVER_H
+#define CONSTRAINT_SOLVER_H
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/SetVector.h"
+
+#include <deque>
+#include <vector>
+
+#include "NodeSetTable.h"
+
+using namespace llvm;
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Inclusion Constraint Solver
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Interface of the points-to solvers used by PointerAnalysis.
+ *
+ * Nodes stand for pointer variables and abstract memory objects alike; the
+ * points-to set of a memory object is the set of objects it may contain.
+ */
+class PointsToSolver {
+public:
+  virtual ~PointsToSolver() = default;
+
+  /**
+   * @brief Create a node.
+   *
+   * @return The number of the node; nodes are numbered from 0.
+   */
+  virtual unsigned makeNode() = 0;
+  virtual unsigned getNumNodes() const = 0;
+
+  /// Ptr = &Obj
+  virtual void addAddressOf(unsigned Ptr, unsigned Obj) = 0;
+  /// Dst = Src
+  virtual void addCopy(unsigned Dst, unsigned Src) = 0;
+  /// Dst = *Ptr
+  virtual void addLoad(unsigned Dst, unsigned Ptr) = 0;
+  /// *Ptr = Src
+  virtual void addStore(unsigned Ptr, unsigned Src) = 0;
+
+  /**
+   * @brief Solve the constraints added so far.
+   *
+   * More constraints may be added afterwards and solve() called again, e.g.
+   * as the targets of indirect calls are found, but every node must be made
+   * before the first call.
+   */
+  virtual void solve() = 0;
+
+  /**
+   * @brief Get the points-to set of N. Nodes known to point to the same
+   * objects may share the same set.
+   */
+  virtual const NodeSet &getPointsTo(unsigned N) const = 0;
+};
+
+/**
+ * @brief Solver of Andersen-style inclusion constraints.
+ *
+ * Constraints are turned into a graph whose edges are copy constraints,
+ * and the points-to sets are propagated along the edges with a worklist.
+ * Only the part of a set that was not propagated yet, its delta, flows to
+ * the successors of a node, and the delta is also what adds the edges of
+ * the load and store constraints of the node.
+ *
+ * Nodes on a cycle of copy edges end up with the same points-to set, so
+ * cycles are collapsed into a single node with union-find. Cycles are
+ * looked for lazily: only when an edge is found to join two nodes with equal
+ * points-to sets, and once per edge.
+ *
+ * Sets are hash-consed in a NodeSetTable: nodes hold set IDs, so nodes with
+ * equal sets share them, comparing two sets is comparing IDs, and the same
+ * delta flowing into the same set is a single table lookup.
+ */
+class ConstraintSolver : public PointsToSolver {
+public:
+  unsigned makeNode() override;
+  unsigned getNumNodes() const override { return Nodes.size(); }
+
+  void addAddressOf(unsigned Ptr, unsigned Obj) override;
+  void addCopy(unsigned Dst, unsigned Src) override;
+  void addLoad(unsigned Dst, unsigned Ptr) override;
+  void addStore(unsigned Ptr, unsigned Src) override;
+
+  /**
+   * @brief Compute the least solution of the constraints added so far.
+   */
+  void solve() override;
+
+  const NodeSet &getPointsTo(unsigned N) const override {
+    return Sets.get(Nodes[getRep(N)].PointsTo);
+  }
+
+  /**
+   * @brief Get the node that N was collapsed into, N itself if none.
+   */
+  unsigned getRep(unsigned N) const {
+    while (Rep[N] != N)
+      N = Rep[N];
+    return N;
+  }
+
+private:
+  using SetID = NodeSetTable::ID;
+
+  struct Node {
+    SetID PointsTo = NodeSetTable::Empty;
+    /// Part of PointsTo already propagated to the successors.
+    SetID Propagated = NodeSetTable::Empty;
+    /// Copy edges: the points-to set of this node flows into them. Targets
+    /// may have been collapsed since, so they go through find().
+    SmallSetVector<unsigned, 4> Succs;
+    /// Nodes loaded from (Dst = *this) and stored into (*this = Src) this
+    /// node.
+    std::vector<unsigned> LoadsTo;
+    std::vector<unsigned> StoresFrom;
+  };
+
+  NodeSetTable Sets;
+  std::vector<Node> Nodes;
+  std::vector<unsigned> Rep;
+  std::deque<unsigned> WorkList;
+  std::vector<bool> Queued;
+  /// Edges from which cycles were already looked for.
+  DenseSet<std::pair<unsigned, unsigned>> Checked;
+
+  void push(unsigned N);
+
+  /**
+   * @brief getRep() with path compression.
+   */
+  unsigned find(unsigned N);
+
+  /**
+   * @brief Collapse Other into N, which stays the representative.
+   */
+  void unite(unsigned N, unsigned Other);
+
+  /**
+   * @brief Collapse every cycle of copy edges reachable from Start, using
+   * Tarjan's algorithm.
+   */
+  void collapseCycles(unsigned Start);
+
+  /**
+   * @brief Add the copy edge From -> To and flow the whole points-to set of
+   * From along it, if the edge is new.
+   */
+  void addEdge(unsigned From, unsigned To);
+
+  /**
+   * @brief Add Set to the points-to set of N, queuing N if it grew.
+   */
+  void include(unsigned N, SetID Set);
+};
+
+} // namespace dataflow
+
+#endif // CONSTRAINT_SOLVER_H
@@ -0,0 +1,110 @@
+#ifndef DEMAND_SOLVER_H
+#define DEMAND_SOLVER_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+
+#include <utility>
+#include <vector>
+
+#include "ConstraintSolver.h"
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Demand-Driven Solver
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Solver of inclusion constraints that only computes the points-to
+ * sets it is asked for.
+ *
+ * solve() does nothing: the constraints are kept as a pointer-assignment
+ * graph, and getPointsTo(N) explores the part of it that N depends on,
+ * i.e. the reachability over copy, load and store edges of CFL-based
+ * demand analyses. Only the nodes N copies from and the pointers it loads
+ * through are visited first, then the memory objects the loads read. The
+ * stores into an object are those whose pointer may point to it: a pointer
+ * that only takes addresses, such as an alloca, points to exactly those
+ * objects, so its stores are indexed by object. The other stores have their
+ * pointer visited once some object is read, and the value they write once
+ * their pointer is found to point to an object being read. The nodes
+ * visited are solved together with the difference propagation of
+ * ConstraintSolver, and then kept, so that later queries stop wherever an
+ * earlier one went.
+ *
+ * A query that visits more than Budget nodes and edges is given up. The
+ * whole graph is then solved by a ConstraintSolver, which answers every
+ * query from then on. Either way the sets are those ConstraintSolver
+ * would compute.
+ *
+ * Queries fill the caches of a const solver, so they must not run
+ * concurrently.
+ */
+class DemandSolver : public PointsToSolver {
+public:
+  explicit DemandSolver(unsigned Budget) : Budget(Budget) {}
+
+  unsigned makeNode() override;
+  unsigned getNumNodes() const override { return Nodes.size(); }
+
+  void addAddressOf(unsigned Ptr, unsigned Obj) override;
+  void addCopy(unsigned Dst, unsigned Src) override;
+  void addLoad(unsigned Dst, unsigned Ptr) override;
+  void addStore(unsigned Ptr, unsigned Src) override;
+
+  void solve() override;
+
+  const NodeSet &getPointsTo(unsigned N) const override;
+
+private:
+  struct Node {
+    /// Is this node the memory of an object, i.e. has its address taken?
+    bool Object = false;
+    SmallVector<unsigned, 1> Objects;
+    SmallVector<unsigned, 2> CopyFrom;
+    /// Pointers this node is loaded through.
+    SmallVector<unsigned, 1> LoadFrom;
+  };
+
+  std::vector<Node> Nodes;
+  /// Pointer and stored value of every store.
+  std::vector<std::pair<unsigned, unsigned>> Stores;
+  unsigned Budget;
+
+  /// Points-to sets of the nodes some query has solved; they are final.
+  mutable std::vector<NodeSet> PointsTo;
+  mutable std::vector<bool> Solved;
+  mutable bool Queried = false;
+
+  /// Values stored into each object by the stores whose pointer only takes
+  /// addresses, and the other stores.
+  mutable DenseMap<unsigned, SmallVector<unsigned, 1>> DirectStores;
+  mutable std::vector<std::pair<unsigned, unsigned>> IndirectStores;
+
+  /**
+   * @brief Sort the stores into DirectStores and IndirectStores.
+   */
+  void indexStores() const;
+
+  /**
+   * @brief Solve N and the nodes it depends on.
+   *
+   * @return false if the budget ran out, in which case nothing is solved.
+   */
+  bool query(unsigned N) const;
+
+  /**
+   * @brief Solve every node with a ConstraintSolver.
+   */
+  void solveExhaustively() const;
+
+  /**
+   * @brief Forget what the queries found, as a new constraint may change it.
+   */
+  void invalidate();
+};
+
+} // namespace dataflow
+
+#endif // DEMAND_SOLVER_H
@@ -1,6 +1,7 @@
 #ifndef DIV_ZERO_ANALYSIS_H
 #define DIV_ZERO_ANALYSIS_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
@@ -12,14 +13,19 @@
 #include <algorithm>
 #include <iterator>
 #include <map>
+#include <memory>
 #include <string>
 
+#include "AbstractMemory.h"
+#include "AnalysisCache.h"
 #include "Domain.h"
+#include "MemoryFlow.h"
+#include "ValueNumbering.h"
 #include "PointerAnalysis.h"
 
 namespace dataflow {
 
-using Memory = std::map<std::string, Domain *>;
+class SummaryTable;
 
 struct DivZeroAnalysis : public FunctionPass {
   static char ID;
@@ -27,6 +33,38 @@ struct DivZeroAnalysis : public FunctionPass {
   ValueMap<Instruction *, Memory *> InMap;
   ValueMap<Instruction *, Memory *> OutMap;
   SetVector<Instruction *> ErrorInsts;
+  ValueNumbering *Numbering = nullptr;
+
+  /**
+   * Memory at the entry of every reachable basic block, as computed by
+   * doBlockAnalysis().
+   */
+  DenseMap<BasicBlock *, Memory> BlockIn;
+  SetVector<Value *> BlockPointerSet;
+
+  /**
+   * With -divzero-memory=memoryssa, the stores that reach each load; the
+   * block solver then skips the transfer function of loads and stores.
+   */
+  std::unique_ptr<MemoryFlow> Flow;
+
+  /**
+   * In interprocedural mode, the summaries that give the result of calls to
+   * defined functions; see InterproceduralAnalysis.
+   */
+  const SummaryTable *Summaries = nullptr;
+
+  /**
+   * If set, the points-to graph of the whole module, used instead of
+   * building one for the function; see InterproceduralAnalysis.
+   */
+  PointerAnalysis *ModulePA = nullptr;
+
+  /**
+   * Domain of each argument at the entry of the function. If empty, every
+   * integer argument is MaybeZero.
+   */
+  std::vector<Domain> ArgDomains;
 
   /**
    * This function is called for each function F in the input C program
@@ -35,13 +73,42 @@ struct DivZeroAnalysis : public FunctionPass {
    */
   bool runOnFunction(Function &F) override;
 
+  /**
+   * @brief Fill InMap, OutMap and ErrorInsts for F, from the cache if
+   * -divzero-cache-dir has them, without printing them.
+   *
+   * @param F The function to be analyzed.
+   * @param PA The points-to graph of F; if null, one is built and printed.
+   */
+  void analyze(Function &F, PointerAnalysis *PA);
+
+  /**
+   * @brief Print the results of analyze() on F.
+   */
+  void printResults(Function &F);
+
+  /**
+   * @brief Free the results of analyze() on F.
+   */
+  void releaseResults(Function &F);
+
+  /**
+   * @brief Run the block solver on F and get the join of the Domains of the
+   * values it returns.
+   *
+   * @param F The function to be analyzed.
+   * @param PA The points-to graph of F.
+   * @return Domain of the return value, Uninit if F never returns one.
+   */
+  Domain analyzeReturn(Function &F, PointerAnalysis *PA);
+
 protected:
   /**
    * This function creates a transfer function that updates the Out Memory based
    * on In Memory and the instruction type/parameters.
    */
   void transfer(Instruction *I, const Memory *In, Memory &NOut,
-                PointerAnalysis *PA, SetVector<Value *> PointerSet);
+                PointerAnalysis *PA, const SetVector<Value *> &PointerSet);
 
   /**
    * @brief This function implements the chaotic iteration algorithm using
@@ -72,6 +139,55 @@ protected:
   void flowOut(Instruction *Inst, Memory *Pre, Memory *Post,
                SetVector<Instruction *> &WorkSet);
 
+  /**
+   * @brief Block-level solver: keeps Memory only at the entry and exit of
+   * each basic block and visits blocks in reverse postorder. Like
+   * transferBlock(), materialize(), analyzeReturn() and buildMemoryFlow(),
+   * it is only built with -DUSE_REFERENCE=ON.
+   *
+   * @param F The function to be analyzed.
+   * @param PA The points-to graph of F.
+   */
+  void doBlockAnalysis(Function &F, PointerAnalysis *PA);
+
+  /**
+   * @brief Build Flow for F if -divzero-memory=memoryssa is given.
+   */
+  void buildMemoryFlow(Function &F, PointerAnalysis *PA);
+
+  /**
+   * @brief Apply the transfer function of every instruction in BB to State.
+   *
+   * @param BB The basic block to evaluate.
+   * @param State The Memory at the entry of BB, updated to its exit.
+   * @param PA The points-to graph of the function.
+   * @param Record If true, also store the In and Out Memory of every
+   * instruction in InMap and OutMap.
+   */
+  void transferBlock(BasicBlock *BB, Memory &State, PointerAnalysis *PA,
+                     bool Record);
+
+  /**
+   * @brief Rebuild the In and Out Memory of every instruction in BB from the
+   * block states computed by doBlockAnalysis().
+   */
+  void materialize(BasicBlock *BB, PointerAnalysis *PA);
+
+  /**
+   * @brief Fill InMap, OutMap and ErrorInsts from the result cached under
+   * Key, if there is one.
+   *
+   * @return true if a result was found.
+   */
+  bool loadCachedResult(Function &F, const AnalysisCache &Cache,
+                        StringRef Key);
+
+  /**
+   * @brief Store InMap, OutMap and ErrorInsts in the cache under Key.
+   */
+  void storeCachedResult(Function &F, const AnalysisCache &Cache,
+                         StringRef Key);
+
   /**
    * Can the Instruction Inst incurr a divide by zero error?
    *
@@ -0,0 +1,114 @@
+#ifndef INTERPROCEDURAL_ANALYSIS_H
+#define INTERPROCEDURAL_ANALYSIS_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+
+#include <memory>
+#include <vector>
+
+#include "AbstractMemory.h"
+#include "DivZeroAnalysis.h"
+#include "Domain.h"
+#include "ValueNumbering.h"
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Function Summaries
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Domain of the return value of a function as a function of the
+ * Domains of its arguments.
+ *
+ * Top is the return Domain when every integer argument is MaybeZero.
+ * IfZero[I] and IfNonZero[I] are the return Domain when argument I is Zero,
+ * resp. NonZero, and every other argument is MaybeZero. Each of them
+ * over-approximates the return value of any call whose arguments are at
+ * most as large, so a call is summarized by the meet of those that apply.
+ * Arguments that are not integers keep Top in both.
+ */
+struct FunctionSummary {
+  Domain Top;
+  std::vector<Domain> IfZero;
+  std::vector<Domain> IfNonZero;
+
+  /**
+   * @brief Domain of the value returned by Call, given the Memory In right
+   * before it.
+   */
+  Domain apply(const CallInst *Call, const Memory &In,
+               const ValueNumbering &VN) const;
+
+  /**
+   * @brief Join Other into this summary.
+   *
+   * @return true if the summary changed.
+   */
+  bool join(const FunctionSummary &Other);
+};
+
+/**
+ * @brief Summaries of the defined functions of a module.
+ *
+ * Entries are created up front by InterproceduralAnalysis, so that threads
+ * analyzing different SCCs can update their own entries while reading those
+ * of their callees.
+ */
+class SummaryTable {
+public:
+  /**
+   * @return The summary of F, or nullptr if F has none, e.g. because it is
+   * only declared or is an indirect callee.
+   */
+  const FunctionSummary *lookup(const Function *F) const {
+    auto It = Summaries.find(F);
+    return It == Summaries.end() ? nullptr : &It->second;
+  }
+
+  FunctionSummary &operator[](const Function *F) { return Summaries[F]; }
+
+private:
+  DenseMap<const Function *, FunctionSummary> Summaries;
+};
+
+//===----------------------------------------------------------------------===//
+// Interprocedural DivZero Analysis
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Interprocedural DivZero analysis.
+ *
+ * The points-to graph is built once for the whole module, and gives the
+ * call graph: indirect calls go to the functions their callee may point to.
+ * Summaries are computed bottom-up over the SCCs of the call graph; the
+ * functions of a recursive SCC are analyzed until their summaries stop
+ * changing. SCCs of the same level, i.e. whose callees are all in lower
+ * levels, do not depend on each other and are analyzed in parallel. Every
+ * function is then analyzed and reported as by DivZeroAnalysis, with calls
+ * to defined functions taking the join of the Domains given by the
+ * summaries of their targets.
+ */
+struct InterproceduralAnalysis : public ModulePass {
+  static char ID;
+  InterproceduralAnalysis() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+private:
+  SummaryTable Summaries;
+  std::unique_ptr<PointerAnalysis> PA;
+
+  /**
+   * @brief Compute the summaries of the functions of one SCC.
+   */
+  void summarize(const std::vector<Function *> &SCC, bool Recursive);
+};
+
+} // namespace dataflow
+
+#endif // INTERPROCEDURAL_ANALYSIS_H
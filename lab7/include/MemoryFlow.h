@@ -0,0 +1,64 @@
+#ifndef MEMORY_FLOW_H
+#define MEMORY_FLOW_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include <vector>
+
+#include "AbstractMemory.h"
+#include "Domain.h"
+#include "PointerAnalysis.h"
+#include "ValueNumbering.h"
+
+using namespace llvm;
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Sparse Memory Flow
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Stores that reach each load of an integer, found once per function
+ * through MemorySSA.
+ *
+ * The MemoryDef chain of every load is walked up from its defining access,
+ * through the MemoryPhis, to the stores it may read. A store through a
+ * pointer that may alias the one of the load, according to PA, is a source
+ * of the load; one through the very same pointer hides the stores above it.
+ * The other stores are skipped. A call is assumed to write the memory its
+ * pointer arguments point to, and any memory that is not a local variable.
+ * The entry of the function, calls and other writes the load may read
+ * make its value unknown.
+ *
+ * The abstract value of a load is then the join of the values stored by its
+ * sources, so stores do not need to update the Memory at all. The MemorySSA
+ * is only kept while the sources are found.
+ */
+class MemoryFlow {
+public:
+  MemoryFlow(Function &F, const PointerAnalysis &PA);
+
+  /**
+   * @brief Get the Domain of the integer loaded by Load.
+   *
+   * @param State The Memory before Load, holding the stored values.
+   * @param VN Numbering of the variables of the function.
+   */
+  Domain getDomain(const LoadInst *Load, const Memory &State,
+                   const ValueNumbering &VN) const;
+
+private:
+  struct Sources {
+    std::vector<const Value *> Values;
+    /// Can the load read something else than Values?
+    bool Unknown = false;
+  };
+
+  DenseMap<const LoadInst *, Sources> Loads;
+};
+
+} // namespace dataflow
+
+#endif // MEMORY_FLOW_H
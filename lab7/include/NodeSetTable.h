@@ -0,0 +1,72 @@
+#ifndef NODE_SET_TABLE_H
+#define NODE_SET_TABLE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/SparseBitVector.h"
+
+#include <deque>
+#include <utility>
+
+using namespace llvm;
+
+namespace dataflow {
+
+/**
+ * @brief Set of nodes of a PointsToSolver. Unions and intersections work
+ * a word at a time, so sets are cheapest when the nodes that appear in them
+ * are numbered close together.
+ */
+using NodeSet = SparseBitVector<>;
+
+/**
+ * @brief Hash-consing table of NodeSets.
+ *
+ * Every distinct set is stored once and named by an ID, so equal sets are
+ * compared by ID and shared by all the nodes that hold them. Unions,
+ * intersections and differences are memoized on their pair of IDs, which
+ * turns the many identical operations of a solver into table lookups. Sets
+ * are never freed before the table is.
+ */
+class NodeSetTable {
+public:
+  using ID = unsigned;
+
+  /// ID of the empty set.
+  static const ID Empty = 0;
+
+  NodeSetTable();
+
+  /**
+   * @brief Get the ID of Set, adding it to the table if it is new.
+   */
+  ID intern(NodeSet Set);
+
+  ID singleton(unsigned N);
+
+  /**
+   * @brief Get the set named S. The reference stays valid as long as the
+   * table.
+   */
+  const NodeSet &get(ID S) const { return Sets[S]; }
+
+  ID unite(ID A, ID B);
+  ID intersect(ID A, ID B);
+  /// A \ B
+  ID subtract(ID A, ID B);
+
+  unsigned size() const { return Sets.size(); }
+
+private:
+  /// A deque, so that get() references survive later insertions.
+  std::deque<NodeSet> Sets;
+  /// IDs of the sets, by hash.
+  DenseMap<unsigned, SmallVector<ID, 1>> Buckets;
+  DenseMap<std::pair<ID, ID>, ID> Unions;
+  DenseMap<std::pair<ID, ID>, ID> Intersections;
+  DenseMap<std::pair<ID, ID>, ID> Differences;
+};
+
+} // namespace dataflow
+
+#endif // NODE_SET_TABLE_H
@@ -1,8 +1,20 @@
 #ifndef POINTER_ANALYSIS_H
 #define POINTER_ANALYSIS_H
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/Function.h"
-#include <set>
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ModuleSlotTracker.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ConstraintSolver.h"
+#include "DemandSolver.h"
 
 using namespace llvm;
 
@@ -12,60 +24,231 @@ namespace dataflow {
 // Pointer Analysis
 //===----------------------------------------------------------------------===//
 
-using PointsToSet = std::set<std::string>;
+/**
+ * @brief PointsToSet represents the set of allocation sites a variable can
+ * point to, by their number.
+ */
+using PointsToSet = NodeSet;
 
 /**
- * @brief PointsToInfo represents the set of allocation sites a variable can point to. 
+ * @brief PointsToInfo holds the distinct PointsToSets of a function;
+ * variables and allocation sites that point to the same objects share one.
  *
  */
-using PointsToInfo = std::map<std::string, PointsToSet>;
+using PointsToInfo = std::vector<PointsToSet>;
 class PointerAnalysis {
 public:
   /**
    * @brief Build a points-to graph
    *
-   * This constructor applies the pointer analysis transfer function
-   * on each instruction in function F.
+   * This constructor extracts the inclusion constraints of every
+   * instruction in function F once and solves them with ConstraintSolver,
+   * or with UnificationSolver if -pta=steens is given. With -pta=demand,
+   * they are kept in a DemandSolver, which only solves what the queries
+   * need, and the graph is not printed.
    *
    * @param F The function for which pointer analysis is done
+   * @param Print If true, print the points-to graph to stderr
+   */
+  PointerAnalysis(Function &F, bool Print = true);
+
+  /**
+   * @brief Build a points-to graph of a whole module
+   *
+   * Global variables, functions and the memory returned by calls to
+   * external functions whose result is noalias, e.g. malloc(), are
+   * allocation sites too. Arguments flow into the parameters of the callee,
+   * the values returned by the callee into the result of the call, and the
+   * initializers of global variables into their memory. The targets of an
+   * indirect call are the functions its callee may point to; they are
+   * resolved on the fly, each time the constraints are solved, until no new
+   * target appears.
+   *
+   * Names are qualified by their function, e.g. main:%3, as the same
+   * variable name is found in many functions.
+   *
+   * @param M The module for which pointer analysis is done
+   * @param Print If true, print the points-to graph to stderr
    */
-  PointerAnalysis(Function &F);
+  PointerAnalysis(Module &M, bool Print = true);
 
   /**
-   * @brief If the instruction is memory allocation, store, or load, updates the points-to sets.
+   * @brief Returns true if two pointers are aliased
    *
-   * @param Inst The instruction to be analyzed for aliasing
-   * @param PointsTo The set of 
+   * @param Ptr1 First pointer, as given by variable() or address()
+   * @param Ptr2 Second pointer, as given by variable() or address()
+   * @return bool
    */
-  void transfer(Instruction *Inst, PointsToInfo &PointsTo);
+  bool alias(std::string &Ptr1, std::string &Ptr2) const;
 
   /**
    * @brief Returns true if two pointers are aliased
    *
    * @param Ptr1 First pointer
    * @param Ptr2 Second pointer
-   * @return bool  
+   * @return bool
    */
-  bool alias(std::string &Ptr1, std::string &Ptr2) const;
+  bool alias(const Value *Ptr1, const Value *Ptr2) const;
+
+  /**
+   * @brief Get the pointers that may alias Ptr, i.e. every Ptr2 for which
+   * alias(Ptr, Ptr2) is true. This includes Ptr if it points to anything.
+   *
+   * @param Ptr Pointer
+   * @param F If given, only the variables of F are returned; needed with
+   * the points-to graph of a module, whose pointers span every function
+   * @return The pointer variables, in program order
+   */
+  ArrayRef<const Value *> getMayAliases(const Value *Ptr,
+                                        const Function *F = nullptr) const;
+
+  /**
+   * @brief Get the functions Call may call: its callee if it is a direct
+   * call, or, with the points-to graph of a module, the functions its
+   * callee may point to.
+   */
+  ArrayRef<const Function *> getCallees(const CallInst *Call) const;
+
+  /**
+   * @brief Get the options that choose how graphs are built, e.g.
+   * "pta=steens", for keys of cached results that depend on them.
+   */
+  static std::string getOptions();
+
+  /**
+   * @brief Print the points-to set of every variable, and of every
+   * allocation site something is stored into, sorted by name. Nothing is
+   * printed with -pta=demand.
+   */
+  void print() const;
 
 private:
+  /**
+   * Allocation sites are numbered first, in program order, so that the
+   * points-to sets only use the low numbers; pointer variables follow.
+   * SetOf gives the index in PointsTo of the set of each number.
+   */
+  bool WholeModule = false;
+  /// Slot numbering shared by the names of a module, while it is built.
+  ModuleSlotTracker *Slots = nullptr;
   PointsToInfo PointsTo;
+  std::vector<unsigned> SetOf;
+  unsigned NumObjects = 0;
+  DenseMap<const Value *, unsigned> Variables;
+  DenseMap<const Value *, unsigned> Objects;
+
+  /**
+   * Printed form of every number, and the other way around, for the
+   * string-based alias().
+   */
+  std::vector<std::string> Names;
+  StringMap<unsigned> Numbers;
+
+  /**
+   * Value of every number; allocation sites have none.
+   */
+  std::vector<const Value *> ValueOf;
+
+  /**
+   * Targets of every call, the functions allocation sites stand for, the
+   * node of the values returned by each function, and the indirect calls
+   * with the node of their callee.
+   */
+  DenseMap<const CallInst *, std::vector<const Function *>> Callees;
+  DenseMap<unsigned, const Function *> FunctionObjects;
+  DenseMap<const Function *, unsigned> Returns;
+  std::vector<std::pair<const CallInst *, unsigned>> IndirectCalls;
+
+  /**
+   * With -pta=demand, the solver that answers queries; PointsTo and SetOf
+   * are then left empty.
+   */
+  std::unique_ptr<DemandSolver> Demand;
+
+  /**
+   * Queries are answered per pair of sets and memoized, as the transfer
+   * function asks the same ones for every instruction it evaluates; with
+   * Demand, per pair of nodes and per node instead of set.
+   * MayAliases has one entry per set of PointsTo and function, filled on
+   * first use; the vectors keep their buffers when the map grows, so the
+   * ArrayRefs handed out stay valid. PointedBy gives the pointer variables
+   * pointing to each allocation site, and is built with the first entry.
+   * The caches are guarded by CacheLock, as the summaries of a module are
+   * computed by several threads sharing one graph.
+   */
+  mutable std::mutex CacheLock;
+  mutable DenseMap<std::pair<unsigned, unsigned>, bool> AliasCache;
+  mutable DenseMap<std::pair<unsigned, const Function *>,
+                   std::vector<const Value *>>
+      MayAliases;
+  mutable std::vector<NodeSet> PointedBy;
+  /// With Demand, the variables of each function, built on first use.
+  mutable DenseMap<const Function *, std::vector<unsigned>> VariablesOf;
+
+  /**
+   * @brief Do the sets at indices S1 and S2 of PointsTo intersect?
+   */
+  bool aliasSets(unsigned S1, unsigned S2) const;
+
+  /**
+   * @brief Do the nodes N1 and N2 point to a common object?
+   */
+  bool aliasNodes(unsigned N1, unsigned N2) const;
 
   /**
-   * @brief 
+   * @brief Printed name of Val, or of the memory it allocates if Object.
+   */
+  std::string getName(const Value *Val, bool Object) const;
+
+  unsigned getVariable(const Value *Val, PointsToSolver &Solver);
+  unsigned getReturn(const Function *F, PointsToSolver &Solver);
+  unsigned addNode(std::string Name, const Value *Val,
+                   PointsToSolver &Solver);
+
+  /**
+   * @brief Add the constraints of Inst to Solver.
    *
-   * @param PointsTo 
-   * @return int 
+   * Allocas are the address-of constraints, loads and stores of pointers the
+   * load and store constraints, and casts, GEPs, phis and selects of
+   * pointers the copy constraints. Fields are not distinguished.
+   */
+  void addConstraints(Instruction *Inst, PointsToSolver &Solver);
+
+  /**
+   * @brief Add the constraints of Call to Solver, in a module: the memory it
+   * allocates, and the flow into and out of its direct callee. Indirect
+   * calls are recorded for resolveIndirectCalls().
+   */
+  void addCallConstraints(CallInst *Call, PointsToSolver &Solver);
+
+  /**
+   * @brief Add the flow of the arguments of Call into the parameters of
+   * Callee, and of the values Callee returns into the result of Call.
    */
-  int countFacts(PointsToInfo &PointsTo);
+  void addCallee(const CallInst *Call, const Function *Callee,
+                 PointsToSolver &Solver);
 
   /**
-   * @brief 
+   * @brief Make the functions the callee of each indirect call points to,
+   * as solved so far, targets of the call.
    *
-   * @param PointsTo 
+   * @return true if a call got a new target, so that Solver must run again.
+   */
+  bool resolveIndirectCalls(PointsToSolver &Solver);
+
+  /**
+   * @brief Add the objects whose address appears in Init, the initializer
+   * of a global variable, to the points-to set of Obj, its memory.
+   */
+  void addInitializer(unsigned Obj, const Constant *Init,
+                      PointsToSolver &Solver);
+
+  /**
+   * @brief Keep the points-to sets of the solved Solver and print them, or
+   * keep Solver itself if it is a DemandSolver.
    */
-  void print(std::map<std::string, PointsToSet> &PointsTo);
+  void finish(std::unique_ptr<PointsToSolver> Solver, bool Print);
 };
 }; // namespace dataflow
 
-#endif // POINTER_ANALYSIS_H
\ No newline at end of file
+#endif // POINTER_ANALYSIS_H
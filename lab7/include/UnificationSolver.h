@@ -0,0 +1,86 @@
+#ifndef UNIFICATION_SOLVER_H
+#define UNIFICATION_SOLVER_H
+
+#include <vector>
+
+#include "ConstraintSolver.h"
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Unification Solver
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Solver of points-to constraints by unification (Steensgaard).
+ *
+ * Nodes are grouped into equivalence classes with union-find, and each class
+ * points to at most one other class. Every constraint is applied once, by
+ * unifying the classes it requires to be equal, so solving takes almost
+ * linear time. The price is precision: once two pointers may point to the
+ * same object, they are taken to point to all the same objects.
+ *
+ * Constraints are only recorded until solve(), so that the classes created
+ * to stand for unknown pointees are numbered after every node of the caller.
+ */
+class UnificationSolver : public PointsToSolver {
+public:
+  unsigned makeNode() override;
+  unsigned getNumNodes() const override { return NumNodes; }
+
+  void addAddressOf(unsigned Ptr, unsigned Obj) override;
+  void addCopy(unsigned Dst, unsigned Src) override;
+  void addLoad(unsigned Dst, unsigned Ptr) override;
+  void addStore(unsigned Ptr, unsigned Src) override;
+
+  void solve() override;
+
+  /**
+   * @return The nodes in the class that N points to; every node of a class
+   * shares the same set.
+   */
+  const NodeSet &getPointsTo(unsigned N) const override;
+
+private:
+  enum Kind { AddressOf, Copy, Load, Store };
+  struct Constraint {
+    Kind K;
+    unsigned Dst;
+    unsigned Src;
+  };
+
+  static const unsigned None = ~0u;
+
+  unsigned NumNodes = 0;
+  std::vector<Constraint> Constraints;
+
+  /// Union-find over the nodes, then over the pointee classes created by
+  /// getPointee().
+  std::vector<unsigned> Rep;
+  std::vector<unsigned> Rank;
+  /// Class pointed to by each representative, None if not known yet.
+  std::vector<unsigned> Pointee;
+
+  /// Nodes of each class, by representative, once solved.
+  std::vector<NodeSet> Members;
+  NodeSet Empty;
+
+  unsigned find(unsigned N);
+  unsigned getRep(unsigned N) const;
+  unsigned makeClass();
+
+  /**
+   * @brief Get the class N points to, creating an empty one if needed.
+   */
+  unsigned getPointee(unsigned N);
+
+  /**
+   * @brief Merge the classes of A and B, and then, recursively, those they
+   * point to.
+   */
+  void unify(unsigned A, unsigned B);
+};
+
+} // namespace dataflow
+
+#endif // UNIFICATION_SOLVER_H
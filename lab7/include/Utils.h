@@ -15,6 +15,12 @@ namespace dataflow {
  */
 std::string variable(const Value *Val);
 
+/**
+ * @brief Same as variable(Val), but reuses the slot numbering of MST instead
+ * of numbering the whole module again on every call.
+ */
+std::string variable(const Value *Val, ModuleSlotTracker &MST);
+
 /**
  * @brief Encode the memory address of an llvm Value
  *
@@ -39,9 +45,11 @@ Domain::Element extractFromValue(const Value *Val);
  *
  * @param Mem Memory containing the domain of Val.
  * @param Val Value whose domain is to be extracted from Mem.
- * @return Domain* Domain of Val in Mem
+ * @param VN Numbering of the variables of the function.
+ * @return Domain Domain of Val in Mem
  */
-Domain *getOrExtract(const Memory *Mem, const Value *Val);
+Domain getOrExtract(const Memory *Mem, const Value *Val,
+                    const ValueNumbering &VN);
 
 /**
  * @brief Print the Memorm Mem in a human readable format to stderr.
@@ -52,8 +60,9 @@ Domain *getOrExtract(const Memory *Mem, const Value *Val);
  *  ...
  *
  * @param Mem Memory to print
+ * @param VN Numbering of the variables of the function
  */
-void printMemory(const Memory *Mem);
+void printMemory(const Memory *Mem, const ValueNumbering &VN);
 
 /**
  * @brief Print the Before and After domains of an instruction
@@ -65,9 +74,10 @@ void printMemory(const Memory *Mem);
  * @param Inst The instruction to print the domains for.
  * @param InMem The incoming memory.
  * @param OutMem The outgoing memory.
+ * @param VN Numbering of the variables of the function.
  */
 void printInstructionTransfer(Instruction *Inst, const Memory *InMem,
-                              const Memory *OutMem);
+                              const Memory *OutMem, const ValueNumbering &VN);
 
 /**
  * @brief Print the In and Out memory of every instruction in function F to
@@ -79,9 +89,11 @@ void printInstructionTransfer(Instruction *Inst, const Memory *InMem,
  * @param F Function whose dataflow analysis result to print.
  * @param InMap Map of In memory of every instruction in function F.
  * @param OutMap Map of Out memory of every instruction in function F.
+ * @param VN Numbering of the variables of the function.
  */
 void printMap(Function &F, ValueMap<Instruction *, Memory *> &InMap,
-              ValueMap<Instruction *, Memory *> &OutMap);
+              ValueMap<Instruction *, Memory *> &OutMap,
+              const ValueNumbering &VN);
 
 } // namespace dataflow
 
@@ -0,0 +1,78 @@
+#ifndef VALUE_NUMBERING_H
+#define VALUE_NUMBERING_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/ModuleSlotTracker.h"
+
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+namespace dataflow {
+
+/**
+ * @brief Dense numbering of the variables of a function.
+ *
+ * Arguments, the globals used by the function and every instruction that
+ * defines a value are numbered once, in program order. Memory is keyed on
+ * these numbers instead of the printed form of a Value.
+ */
+class ValueNumbering {
+public:
+  /**
+   * @brief Number returned by lookup() for values that are not variables of
+   * the function, e.g. constants.
+   */
+  static const unsigned None = ~0u;
+
+  /**
+   * @brief Number the variables of function F.
+   *
+   * @param F Function whose variables to number.
+   */
+  explicit ValueNumbering(const Function &F);
+
+  /**
+   * @brief Get the number of a variable.
+   *
+   * @param Val Value to look up.
+   * @return Number of Val, or None if Val is not a variable of the function.
+   */
+  unsigned lookup(const Value *Val) const;
+
+  /**
+   * @brief Get the variable with number N.
+   */
+  const Value *getValue(unsigned N) const { return Values[N]; }
+
+  /**
+   * @brief Get the number of variables in the function.
+   */
+  unsigned size() const { return Values.size(); }
+
+  /**
+   * @brief Get the human-readable name of the variable with number N, as
+   * rendered by variable(). Names are only rendered when first printed.
+   */
+  const std::string &getName(unsigned N) const;
+
+  /**
+   * @brief Render names with the slot numbering of MST, which must outlive
+   * this numbering, instead of numbering the module for every name.
+   */
+  void setSlotTracker(ModuleSlotTracker *Tracker) { MST = Tracker; }
+
+private:
+  DenseMap<const Value *, unsigned> Numbers;
+  std::vector<const Value *> Values;
+  mutable std::vector<std::string> Names;
+  ModuleSlotTracker *MST = nullptr;
+
+  void number(const Value *Val);
+};
+
+} // namespace dataflow
+
+#endif // VALUE_NUMBERING_H
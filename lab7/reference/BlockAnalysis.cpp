@@ -0,0 +1,128 @@
+#include "DivZeroAnalysis.h"
+#include "InterproceduralAnalysis.h"
+#include "MonotoneSolver.h"
+#include "Utils.h"
+
+namespace dataflow {
+
+void DivZeroAnalysis::transferBlock(BasicBlock *BB, Memory &State,
+                                    PointerAnalysis *PA, bool Record) {
+  for (Instruction &Inst : *BB) {
+    // With Flow, stores leave the Memory alone, and loads take the values
+    // of the stores that reach them.
+    if (Flow && isa<StoreInst>(&Inst)) {
+      if (Record) {
+        InMap[&Inst] = new Memory(State);
+        OutMap[&Inst] = new Memory(State);
+      }
+      continue;
+    }
+    Memory Out(State);
+    if (Flow && isa<LoadInst>(&Inst)) {
+      if (Inst.getType()->isIntegerTy())
+        Out[Numbering->lookup(&Inst)] =
+            Flow->getDomain(cast<LoadInst>(&Inst), State, *Numbering);
+    } else {
+      transfer(&Inst, &State, Out, PA, BlockPointerSet);
+    }
+    // In interprocedural mode, the result of a call to defined functions
+    // comes from their summaries.
+    if (Summaries) {
+      if (auto Call = dyn_cast<CallInst>(&Inst)) {
+        Domain Result(Domain::Uninit);
+        ArrayRef<const Function *> Callees = PA->getCallees(Call);
+        bool Summarized = !Callees.empty();
+        for (const Function *Callee : Callees) {
+          auto Summary = Summaries->lookup(Callee);
+          if (!Summary) {
+            Summarized = false;
+            break;
+          }
+          Result = Domain::join(Result,
+                                Summary->apply(Call, State, *Numbering));
+        }
+        if (Summarized)
+          Out[Numbering->lookup(Call)] = Result;
+      }
+    }
+    if (Record) {
+      InMap[&Inst] = new Memory(State);
+      OutMap[&Inst] = new Memory(Out);
+    }
+    State = std::move(Out);
+  }
+}
+
+void DivZeroAnalysis::materialize(BasicBlock *BB, PointerAnalysis *PA) {
+  // Unreachable blocks have no entry state and start from an empty Memory.
+  auto It = BlockIn.find(BB);
+  Memory State = It == BlockIn.end() ? Memory() : It->second;
+  transferBlock(BB, State, PA, true);
+}
+
+/**
+ * @brief Block-level counterpart of doAnalysis.
+ *
+ * Instead of a Memory per instruction, only the Memory at the entry and exit
+ * of each basic block is kept; the instructions of a block are evaluated in
+ * order with transferBlock(). MonotoneSolver visits blocks in reverse
+ * postorder, so a block is normally evaluated after all of its forward
+ * predecessors and each loop is iterated as a whole.
+ *
+ * @param F The function to be analyzed.
+ */
+void DivZeroAnalysis::doBlockAnalysis(Function &F, PointerAnalysis *PA) {
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+       ++Iter) {
+    BlockPointerSet.insert(&(*Iter));
+  }
+  buildMemoryFlow(F, PA);
+
+  auto Transfer = [this, PA](BasicBlock *BB, Memory &State) {
+    transferBlock(BB, State, PA, false);
+  };
+  MonotoneSolver<Memory, Forward, decltype(Transfer)> Solver(F, Transfer);
+
+  // Arguments of the function can hold any value, unless the caller of
+  // doBlockAnalysis knows better.
+  Memory Entry;
+  for (Argument &Arg : F.args()) {
+    if (!Arg.getType()->isIntegerTy())
+      continue;
+    Entry[Numbering->lookup(&Arg)] = ArgDomains.empty()
+                                         ? Domain(Domain::MaybeZero)
+                                         : ArgDomains[Arg.getArgNo()];
+  }
+  Solver.setBoundary(Entry);
+  Solver.solve();
+
+  for (BasicBlock &BB : F) {
+    if (const Memory *In = Solver.getIn(&BB))
+      BlockIn[&BB] = *In;
+  }
+}
+
+Domain DivZeroAnalysis::analyzeReturn(Function &F, PointerAnalysis *PA) {
+  Numbering = new ValueNumbering(F);
+  doBlockAnalysis(F, PA);
+
+  Domain Result(Domain::Uninit);
+  for (auto &Entry : BlockIn) {
+    auto Return = dyn_cast<ReturnInst>(Entry.first->getTerminator());
+    if (!Return || !Return->getReturnValue())
+      continue;
+    Memory State(Entry.second);
+    transferBlock(Entry.first, State, PA, false);
+    Result = Domain::join(
+        Result, getOrExtract(&State, Return->getReturnValue(), *Numbering));
+  }
+
+  delete Numbering;
+  Numbering = nullptr;
+  BlockIn.clear();
+  BlockPointerSet.clear();
+  Flow.reset();
+  return Result;
+}
+
+} // namespace dataflow
@@ -0,0 +1,275 @@
+#include "InterproceduralAnalysis.h"
+#include "Utils.h"
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+
+namespace dataflow {
+
+static cl::opt<unsigned> Threads(
+    "divzero-ipa-threads",
+    cl::desc("Number of threads computing function summaries (0 uses one per "
+             "hardware thread)"),
+    cl::init(0));
+
+//===----------------------------------------------------------------------===//
+// Function Summaries
+//===----------------------------------------------------------------------===//
+
+Domain FunctionSummary::apply(const CallInst *Call, const Memory &In,
+                              const ValueNumbering &VN) const {
+  Domain Result = Top;
+  // Extra arguments of a variadic call are not summarized.
+  for (unsigned I = 0, E = std::min<size_t>(Call->arg_size(),
+                                            IfZero.size());
+       I < E; ++I) {
+    Domain Arg = getOrExtract(&In, Call->getArgOperand(I), VN);
+    if (Arg.Value == Domain::Zero)
+      Result = Domain::meet(Result, IfZero[I]);
+    else if (Arg.Value == Domain::NonZero)
+      Result = Domain::meet(Result, IfNonZero[I]);
+  }
+  return Result;
+}
+
+bool FunctionSummary::join(const FunctionSummary &Other) {
+  bool Changed = false;
+  auto JoinInto = [&Changed](Domain &Into, Domain D) {
+    Domain Joined = Domain::join(Into, D);
+    Changed |= !Domain::equal(Joined, Into);
+    Into = Joined;
+  };
+  JoinInto(Top, Other.Top);
+  for (size_t I = 0, E = Other.IfZero.size(); I < E; ++I) {
+    JoinInto(IfZero[I], Other.IfZero[I]);
+    JoinInto(IfNonZero[I], Other.IfNonZero[I]);
+  }
+  return Changed;
+}
+
+//===----------------------------------------------------------------------===//
+// Interprocedural DivZero Analysis
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Call Fn(I) for every I in [0, N), on up to NumThreads threads.
+ */
+template <typename Callable>
+static void parallelFor(size_t N, unsigned NumThreads, Callable Fn) {
+  std::atomic<size_t> Next(0);
+  auto Work = [&]() {
+    for (size_t I = Next++; I < N; I = Next++)
+      Fn(I);
+  };
+  std::vector<std::thread> Workers;
+  for (size_t T = 1, E = std::min<size_t>(NumThreads, N); T < E; ++T)
+    Workers.emplace_back(Work);
+  Work();
+  for (std::thread &Worker : Workers)
+    Worker.join();
+}
+
+/**
+ * @brief Get the SCCs of the defined functions of M, callees first.
+ *
+ * @param PA The points-to graph of M, which gives the targets of each call.
+ * @param Recursive Set to whether each SCC calls itself.
+ */
+static std::vector<std::vector<Function *>>
+findSCCs(Module &M, const PointerAnalysis &PA, std::vector<bool> &Recursive) {
+  DenseMap<const Function *, std::vector<Function *>> Succs;
+  for (Function &F : M) {
+    for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E;
+         ++Iter) {
+      auto Call = dyn_cast<CallInst>(&*Iter);
+      if (!Call)
+        continue;
+      for (const Function *Callee : PA.getCallees(Call)) {
+        if (!Callee->isDeclaration())
+          Succs[&F].push_back(const_cast<Function *>(Callee));
+      }
+    }
+  }
+
+  // Tarjan's algorithm, without recursion, as call chains can be long.
+  std::vector<std::vector<Function *>> SCCs;
+  DenseMap<const Function *, unsigned> Index;
+  DenseMap<const Function *, unsigned> Low;
+  std::vector<Function *> Stack;
+  DenseSet<const Function *> OnStack;
+  std::vector<std::pair<Function *, unsigned>> Path;
+  unsigned Count = 0;
+
+  auto Visit = [&](Function *F) {
+    Index[F] = Count;
+    Low[F] = Count;
+    ++Count;
+    Stack.push_back(F);
+    OnStack.insert(F);
+    Path.push_back(std::make_pair(F, 0u));
+  };
+
+  for (Function &Start : M) {
+    if (Start.isDeclaration() || Index.count(&Start))
+      continue;
+    Visit(&Start);
+    while (!Path.empty()) {
+      Function *F = Path.back().first;
+      unsigned I = Path.back().second;
+      std::vector<Function *> &FSuccs = Succs[F];
+      if (I < FSuccs.size()) {
+        ++Path.back().second;
+        Function *W = FSuccs[I];
+        if (!Index.count(W))
+          Visit(W);
+        else if (OnStack.count(W))
+          Low[F] = std::min(Low[F], Index[W]);
+        continue;
+      }
+
+      Path.pop_back();
+      if (!Path.empty()) {
+        Function *Parent = Path.back().first;
+        Low[Parent] = std::min(Low[Parent], Low[F]);
+      }
+      if (Low[F] != Index[F])
+        continue;
+      std::vector<Function *> SCC;
+      while (true) {
+        Function *W = Stack.back();
+        Stack.pop_back();
+        OnStack.erase(W);
+        SCC.push_back(W);
+        if (W == F)
+          break;
+      }
+      Recursive.push_back(SCC.size() > 1 || is_contained(FSuccs, F));
+      SCCs.push_back(std::move(SCC));
+    }
+  }
+  return SCCs;
+}
+
+void InterproceduralAnalysis::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+}
+
+void InterproceduralAnalysis::summarize(const std::vector<Function *> &SCC,
+                                        bool Recursive) {
+  // Only functions returning an integer have a summary.
+  std::vector<Function *> Summarized;
+  for (Function *F : SCC) {
+    if (Summaries.lookup(F))
+      Summarized.push_back(F);
+  }
+
+  DivZeroAnalysis Analysis;
+  Analysis.Summaries = &Summaries;
+  bool Changed;
+  do {
+    Changed = false;
+    for (Function *F : Summarized) {
+      Analysis.ArgDomains.assign(F->arg_size(), Domain(Domain::MaybeZero));
+
+      FunctionSummary New;
+      New.Top = Analysis.analyzeReturn(*F, PA.get());
+      New.IfZero.assign(F->arg_size(), New.Top);
+      New.IfNonZero.assign(F->arg_size(), New.Top);
+      // Refining an argument can only shrink the result, so there is nothing
+      // to refine if F returns no value at all.
+      if (New.Top.Value != Domain::Uninit) {
+        for (Argument &Arg : F->args()) {
+          if (!Arg.getType()->isIntegerTy())
+            continue;
+          unsigned N = Arg.getArgNo();
+          Analysis.ArgDomains[N] = Domain(Domain::Zero);
+          New.IfZero[N] = Analysis.analyzeReturn(*F, PA.get());
+          Analysis.ArgDomains[N] = Domain(Domain::NonZero);
+          New.IfNonZero[N] = Analysis.analyzeReturn(*F, PA.get());
+          Analysis.ArgDomains[N] = Domain(Domain::MaybeZero);
+        }
+      }
+      Changed |= Summaries[F].join(New);
+    }
+  } while (Recursive && Changed);
+}
+
+bool InterproceduralAnalysis::runOnModule(Module &M) {
+  PA.reset(new PointerAnalysis(M));
+
+  // The level of an SCC is one more than the highest level of the SCCs it
+  // calls.
+  std::vector<bool> Recursive;
+  std::vector<std::vector<Function *>> SCCs = findSCCs(M, *PA, Recursive);
+  std::vector<unsigned> Level;
+  DenseMap<const Function *, unsigned> SCCOf;
+  for (auto &SCC : SCCs) {
+    unsigned L = 0;
+    for (Function *F : SCC) {
+      for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E;
+           ++Iter) {
+        auto Call = dyn_cast<CallInst>(&*Iter);
+        if (!Call)
+          continue;
+        for (const Function *Callee : PA->getCallees(Call)) {
+          auto Found = SCCOf.find(Callee);
+          if (Found != SCCOf.end())
+            L = std::max(L, Level[Found->second] + 1);
+        }
+      }
+    }
+    for (Function *F : SCC)
+      SCCOf[F] = Level.size();
+    Level.push_back(L);
+  }
+
+  // Every summary starts at bottom and is created before any thread starts.
+  for (auto &SCC : SCCs) {
+    for (Function *F : SCC) {
+      if (!F->getReturnType()->isIntegerTy())
+        continue;
+      FunctionSummary &Summary = Summaries[F];
+      Summary.IfZero.assign(F->arg_size(), Domain(Domain::Uninit));
+      Summary.IfNonZero.assign(F->arg_size(), Domain(Domain::Uninit));
+    }
+  }
+
+  std::vector<std::vector<unsigned>> ByLevel;
+  for (unsigned I = 0, E = SCCs.size(); I < E; ++I) {
+    if (Level[I] >= ByLevel.size())
+      ByLevel.resize(Level[I] + 1);
+    ByLevel[Level[I]].push_back(I);
+  }
+  unsigned NumThreads = Threads;
+  if (NumThreads == 0)
+    NumThreads = std::max(1u, std::thread::hardware_concurrency());
+  for (auto &SCCsOfLevel : ByLevel) {
+    parallelFor(SCCsOfLevel.size(), NumThreads, [&](size_t I) {
+      unsigned Index = SCCsOfLevel[I];
+      summarize(SCCs[Index], Recursive[Index]);
+    });
+  }
+
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    DivZeroAnalysis Analysis;
+    Analysis.Summaries = &Summaries;
+    Analysis.ModulePA = PA.get();
+    Analysis.runOnFunction(F);
+  }
+  PA.reset();
+  return false;
+}
+
+char InterproceduralAnalysis::ID = 1;
+static RegisterPass<InterproceduralAnalysis>
+    Y("DivZero-inter", "Interprocedural Divide-by-zero Analysis", false, false);
+} // namespace dataflow
@@ -0,0 +1,123 @@
+#include "MemoryFlow.h"
+#include "Utils.h"
+
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Triple.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
+
+namespace dataflow {
+
+/**
+ * @brief Can Inst, which writes memory but is not a store, write the memory
+ * Load reads?
+ */
+static bool mayClobber(const Instruction *Inst, const LoadInst *Load,
+                       const PointerAnalysis &PA) {
+  auto Call = dyn_cast<CallInst>(Inst);
+  if (!Call)
+    return true;
+  if (auto Intrinsic = dyn_cast<IntrinsicInst>(Call)) {
+    if (Intrinsic->getIntrinsicID() == Intrinsic::lifetime_start ||
+        Intrinsic->getIntrinsicID() == Intrinsic::lifetime_end)
+      return false;
+  }
+  const Value *Ptr = Load->getPointerOperand();
+  if (!isa<AllocaInst>(Ptr->stripInBoundsOffsets()))
+    return true;
+  for (const Use &Arg : Call->args()) {
+    if (Arg->getType()->isPointerTy() && PA.alias(Arg.get(), Ptr))
+      return true;
+  }
+  return false;
+}
+
+MemoryFlow::MemoryFlow(Function &F, const PointerAnalysis &PA) {
+  // No alias analysis is registered, so every write is a MemoryDef of the
+  // same chain, and PA tells which ones a load may read.
+  TargetLibraryInfoImpl TLII(Triple(F.getParent()->getTargetTriple()));
+  TargetLibraryInfo TLI(TLII);
+  AAResults AA(TLI);
+  DominatorTree DT(F);
+  MemorySSA MSSA(F, &AA, &DT);
+
+  // Loads through the same pointer from the same access share their walk.
+  DenseMap<std::pair<MemoryAccess *, const Value *>, const LoadInst *> Walked;
+
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+       ++Iter) {
+    auto Load = dyn_cast<LoadInst>(&*Iter);
+    if (!Load || !Load->getType()->isIntegerTy())
+      continue;
+    const Value *Ptr = Load->getPointerOperand();
+    MemoryAccess *Start = MSSA.getMemoryAccess(Load)->getDefiningAccess();
+    auto Key = std::make_pair(Start, Ptr);
+    auto It = Walked.find(Key);
+    if (It != Walked.end()) {
+      Sources Shared = Loads[It->second];
+      Loads[Load] = std::move(Shared);
+      continue;
+    }
+
+    Sources Result;
+    SmallPtrSet<MemoryAccess *, 16> Visited;
+    SmallVector<MemoryAccess *, 16> WorkList;
+    WorkList.push_back(Start);
+    while (!WorkList.empty() && !Result.Unknown) {
+      MemoryAccess *Access = WorkList.pop_back_val();
+      if (!Visited.insert(Access).second)
+        continue;
+      if (MSSA.isLiveOnEntryDef(Access)) {
+        Result.Unknown = true;
+        break;
+      }
+      if (auto Phi = dyn_cast<MemoryPhi>(Access)) {
+        for (unsigned I = 0, E = Phi->getNumIncomingValues(); I < E; ++I)
+          WorkList.push_back(Phi->getIncomingValue(I));
+        continue;
+      }
+
+      auto Def = cast<MemoryDef>(Access);
+      Instruction *Inst = Def->getMemoryInst();
+      if (auto Store = dyn_cast<StoreInst>(Inst)) {
+        const Value *StorePtr = Store->getPointerOperand();
+        bool Same =
+            StorePtr->stripPointerCasts() == Ptr->stripPointerCasts();
+        if (Same || PA.alias(StorePtr, Ptr)) {
+          // Only a value of the same type keeps its zero-ness.
+          if (Store->getValueOperand()->getType() != Load->getType()) {
+            Result.Unknown = true;
+            break;
+          }
+          Result.Values.push_back(Store->getValueOperand());
+          if (Same)
+            continue;
+        }
+      } else if (mayClobber(Inst, Load, PA)) {
+        Result.Unknown = true;
+        break;
+      }
+      WorkList.push_back(Def->getDefiningAccess());
+    }
+
+    Loads[Load] = std::move(Result);
+    Walked[Key] = Load;
+  }
+}
+
+Domain MemoryFlow::getDomain(const LoadInst *Load, const Memory &State,
+                             const ValueNumbering &VN) const {
+  auto It = Loads.find(Load);
+  if (It == Loads.end() || It->second.Unknown)
+    return Domain(Domain::MaybeZero);
+  Domain Result(Domain::Uninit);
+  for (const Value *Val : It->second.Values)
+    Result = Domain::join(Result, getOrExtract(&State, Val, VN));
+  return Result;
+}
+
+} // namespace dataflow
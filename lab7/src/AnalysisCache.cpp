@@ -0,0 +1,180 @@
+#include "AnalysisCache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <dlfcn.h>
+
+namespace dataflow {
+
+/// Start of every cache file.
+static const uint64_t Magic = 0x314f52455a564944ULL; // "DIVZERO1"
+
+/// Stored instead of a word count when a memory equals the previous one,
+/// which is the case for most In memories and for every memory of the
+/// sparse solver.
+static const uint64_t Repeat = ~0ULL;
+
+// Integers are stored little-endian, whatever the host.
+
+static void writeWord(raw_ostream &OS, uint64_t Word) {
+  char Bytes[8];
+  for (unsigned I = 0; I < 8; ++I)
+    Bytes[I] = static_cast<char>(Word >> (8 * I));
+  OS.write(Bytes, 8);
+}
+
+static bool readWord(StringRef &Data, uint64_t &Word) {
+  if (Data.size() < 8)
+    return false;
+  Word = 0;
+  for (unsigned I = 0; I < 8; ++I)
+    Word |= static_cast<uint64_t>(static_cast<unsigned char>(Data[I]))
+            << (8 * I);
+  Data = Data.drop_front(8);
+  return true;
+}
+
+static void writeMemories(raw_ostream &OS, const std::vector<Memory> &Mems) {
+  writeWord(OS, Mems.size());
+  const Memory *Prev = nullptr;
+  for (const Memory &Mem : Mems) {
+    if (Prev && *Prev == Mem) {
+      writeWord(OS, Repeat);
+    } else {
+      writeWord(OS, Mem.getWords().size());
+      for (uint64_t Word : Mem.getWords())
+        writeWord(OS, Word);
+    }
+    Prev = &Mem;
+  }
+}
+
+static bool readMemories(StringRef &Data, std::vector<Memory> &Mems) {
+  uint64_t Count;
+  if (!readWord(Data, Count) || Count > Data.size() / 8)
+    return false;
+  Mems.clear();
+  Mems.reserve(Count);
+  for (uint64_t I = 0; I < Count; ++I) {
+    uint64_t Size;
+    if (!readWord(Data, Size))
+      return false;
+    if (Size == Repeat) {
+      if (Mems.empty())
+        return false;
+      Mems.push_back(Mems.back());
+      continue;
+    }
+    if (Size > Data.size() / 8)
+      return false;
+    std::vector<uint64_t> Words(Size);
+    for (uint64_t &Word : Words)
+      readWord(Data, Word);
+    Mems.push_back(Memory(std::move(Words)));
+  }
+  return true;
+}
+
+/**
+ * @brief MD5 of the file of the loaded pass plugin, so that results computed
+ * by another build of the analysis, e.g. before a change to transfer(), are
+ * not reused. If the file cannot be found, only Version tells builds apart.
+ */
+static const std::string &getBuildID() {
+  static const std::string ID = [] {
+    Dl_info Info;
+    if (dladdr(reinterpret_cast<void *>(&getBuildID), &Info) &&
+        Info.dli_fname) {
+      if (auto Buffer = MemoryBuffer::getFile(Info.dli_fname)) {
+        MD5 Hash;
+        Hash.update((*Buffer)->getBuffer());
+        MD5::MD5Result Result;
+        Hash.final(Result);
+        return Result.digest().str().str();
+      }
+    }
+    return std::string("unknown");
+  }();
+  return ID;
+}
+
+std::string AnalysisCache::getKey(const Function &F, StringRef Config) const {
+  std::string Text;
+  raw_string_ostream OS(Text);
+  OS << "v" << Version << "\n" << getBuildID() << "\n" << Config << "\n";
+  // Printed with a fresh slot numbering, so that the text only depends on
+  // the module and not on what was printed before.
+  F.print(OS);
+  OS.flush();
+
+  MD5 Hash;
+  Hash.update(Text);
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  return Result.digest().str().str();
+}
+
+std::string AnalysisCache::getPath(StringRef Key) const {
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, Key + ".dzc");
+  return Path.str().str();
+}
+
+bool AnalysisCache::load(StringRef Key, CachedResult &Result) const {
+  auto Buffer = MemoryBuffer::getFile(getPath(Key));
+  if (!Buffer)
+    return false;
+  StringRef Data = (*Buffer)->getBuffer();
+
+  uint64_t Word;
+  if (!readWord(Data, Word) || Word != Magic || !readWord(Data, Word) ||
+      Word != Version)
+    return false;
+  if (!readMemories(Data, Result.In) || !readMemories(Data, Result.Out))
+    return false;
+
+  uint64_t Count;
+  if (!readWord(Data, Count) || Count != Data.size() / 8)
+    return false;
+  Result.ErrorInsts.clear();
+  for (uint64_t I = 0; I < Count; ++I) {
+    readWord(Data, Word);
+    Result.ErrorInsts.push_back(Word);
+  }
+  return Result.In.size() == Result.Out.size();
+}
+
+void AnalysisCache::store(StringRef Key, const CachedResult &Result) const {
+  if (sys::fs::create_directories(Dir))
+    return;
+
+  int FD;
+  SmallString<128> TempPath;
+  if (sys::fs::createUniqueFile(getPath(Key) + ".tmp%%%%%%", FD, TempPath))
+    return;
+  {
+    raw_fd_ostream OS(FD, /* shouldClose */ true);
+    writeWord(OS, Magic);
+    writeWord(OS, Version);
+    writeMemories(OS, Result.In);
+    writeMemories(OS, Result.Out);
+    writeWord(OS, Result.ErrorInsts.size());
+    for (unsigned Index : Result.ErrorInsts)
+      writeWord(OS, Index);
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TempPath);
+      return;
+    }
+  }
+  if (sys::fs::rename(TempPath, getPath(Key)))
+    sys::fs::remove(TempPath);
+}
+
+} // namespace dataflow
@@ -0,0 +1,151 @@
+#include "AnalysisPasses.h"
+#include "Utils.h"
+
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Passes/PassPlugin.h"
+
+namespace dataflow {
+
+/**
+ * @brief Has the pass that left PA preserved the analysis Pass?
+ */
+template <typename Pass> static bool isPreserved(const PreservedAnalyses &PA) {
+  auto Checker = PA.getChecker<Pass>();
+  return Checker.preserved() ||
+         Checker.template preservedSet<AllAnalysesOn<Function>>();
+}
+
+AnalysisKey PointerAnalysisPass::Key;
+
+bool PointerAnalysisPass::Result::invalidate(
+    Function &F, const PreservedAnalyses &PA,
+    FunctionAnalysisManager::Invalidator &Inv) {
+  return !isPreserved<PointerAnalysisPass>(PA);
+}
+
+PointerAnalysisPass::Result
+PointerAnalysisPass::run(Function &F, FunctionAnalysisManager &AM) {
+  return Result(std::unique_ptr<PointerAnalysis>(new PointerAnalysis(F, false)));
+}
+
+AnalysisKey DivZeroAnalysisPass::Key;
+
+DivZeroAnalysisPass::Result::~Result() {
+  if (Analysis)
+    Analysis->releaseResults(*F);
+}
+
+Domain DivZeroAnalysisPass::Result::getDivisor(Instruction *Div) const {
+  const Memory *In = getIn(Div);
+  if (!In)
+    return Domain(Domain::MaybeZero);
+  return getOrExtract(In, Div->getOperand(1), *Analysis->Numbering);
+}
+
+bool DivZeroAnalysisPass::Result::invalidate(
+    Function &F, const PreservedAnalyses &PA,
+    FunctionAnalysisManager::Invalidator &Inv) {
+  return !isPreserved<DivZeroAnalysisPass>(PA) ||
+         Inv.invalidate<PointerAnalysisPass>(F, PA);
+}
+
+DivZeroAnalysisPass::Result
+DivZeroAnalysisPass::run(Function &F, FunctionAnalysisManager &AM) {
+  std::unique_ptr<DivZeroAnalysis> Analysis(new DivZeroAnalysis());
+  Analysis->analyze(F, &AM.getResult<PointerAnalysisPass>(F).getGraph());
+  return Result(F, std::move(Analysis));
+}
+
+PreservedAnalyses DivZeroPrinterPass::run(Function &F,
+                                          FunctionAnalysisManager &AM) {
+  outs() << "Running DivZero on " << F.getName() << "\n";
+  AM.getResult<PointerAnalysisPass>(F).getGraph().print();
+  AM.getResult<DivZeroAnalysisPass>(F).print();
+  return PreservedAnalyses::all();
+}
+
+const char *DivZeroAnnotatePass::SafeDivisionMD = "divzero.safe";
+const char *DivZeroAnnotatePass::AnnotatedFlag = "divzero.annotated";
+
+PreservedAnalyses DivZeroAnnotatePass::run(Module &M,
+                                           ModuleAnalysisManager &AM) {
+  auto &FAM = AM.getResult<FunctionAnalysisManagerModuleProxy>(M).getManager();
+  bool Changed = false;
+  if (!M.getModuleFlag(AnnotatedFlag)) {
+    M.addModuleFlag(Module::Warning, AnnotatedFlag, 1);
+    Changed = true;
+  }
+  for (Function &F : M) {
+    if (!F.isDeclaration())
+      Changed |= annotate(F, FAM);
+  }
+  if (!Changed)
+    return PreservedAnalyses::all();
+  // Metadata and module flags change neither the points-to graphs nor the
+  // DivZero results of the functions.
+  PreservedAnalyses PA;
+  PA.preserveSet<CFGAnalyses>();
+  PA.preserve<FunctionAnalysisManagerModuleProxy>();
+  PA.preserve<PointerAnalysisPass>();
+  PA.preserve<DivZeroAnalysisPass>();
+  return PA;
+}
+
+bool DivZeroAnnotatePass::annotate(Function &F, FunctionAnalysisManager &AM) {
+  auto &Result = AM.getResult<DivZeroAnalysisPass>(F);
+  bool Changed = false;
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+       ++Iter) {
+    auto Inst = &(*Iter);
+    if (Inst->getOpcode() != Instruction::SDiv &&
+        Inst->getOpcode() != Instruction::UDiv)
+      continue;
+    if (Domain::equal(Result.getDivisor(Inst), Domain::NonZero)) {
+      Inst->setMetadata(SafeDivisionMD, MDNode::get(F.getContext(), None));
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+} // namespace dataflow
+
+using namespace dataflow;
+
+extern "C" LLVM_ATTRIBUTE_WEAK PassPluginLibraryInfo llvmGetPassPluginInfo() {
+  return {LLVM_PLUGIN_API_VERSION, "DivZeroPass", "0.1", [](PassBuilder &PB) {
+            PB.registerAnalysisRegistrationCallback(
+                [](FunctionAnalysisManager &FAM) {
+                  FAM.registerPass([] { return PointerAnalysisPass(); });
+                  FAM.registerPass([] { return DivZeroAnalysisPass(); });
+                });
+            PB.registerPipelineParsingCallback(
+                [](StringRef Name, FunctionPassManager &FPM,
+                   ArrayRef<PassBuilder::PipelineElement>) {
+                  if (Name == "DivZero") {
+                    FPM.addPass(DivZeroPrinterPass());
+                    return true;
+                  }
+                  if (Name == "require<points-to>") {
+                    FPM.addPass(
+                        RequireAnalysisPass<PointerAnalysisPass, Function>());
+                    return true;
+                  }
+                  if (Name == "require<divzero>") {
+                    FPM.addPass(
+                        RequireAnalysisPass<DivZeroAnalysisPass, Function>());
+                    return true;
+                  }
+                  return false;
+                });
+            PB.registerPipelineParsingCallback(
+                [](StringRef Name, ModulePassManager &MPM,
+                   ArrayRef<PassBuilder::PipelineElement>) {
+                  if (Name == "DivZero-annotate") {
+                    MPM.addPass(DivZeroAnnotatePass());
+                    return true;
+                  }
+                  return false;
+                });
+          }};
+}
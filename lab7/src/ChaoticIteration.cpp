@@ -11,20 +11,12 @@ namespace dataflow {
  */
 std::vector<Instruction *> getPredecessors(Instruction *Inst) {
   std::vector<Instruction *> Ret;
-  auto Block = Inst->getParent();
-  for (auto Iter = Block->rbegin(), End = Block->rend(); Iter != End; ++Iter) {
-    if (&(*Iter) == Inst) {
-      ++Iter;
-      if (Iter != End) {
-        Ret.push_back(&(*Iter));
-        return Ret;
-      }
-      for (auto Pre = pred_begin(Block), BE = pred_end(Block); Pre != BE;
-           ++Pre) {
-        Ret.push_back(&(*((*Pre)->rbegin())));
-      }
-      return Ret;
-    }
+  if (auto Prev = Inst->getPrevNode()) {
+    Ret.push_back(Prev);
+    return Ret;
+  }
+  for (auto Pred : predecessors(Inst->getParent())) {
+    Ret.push_back(Pred->getTerminator());
   }
   return Ret;
 }
@@ -37,20 +29,12 @@ std::vector<Instruction *> getPredecessors(Instruction *Inst) {
  */
 std::vector<Instruction *> getSuccessors(Instruction *Inst) {
   std::vector<Instruction *> Ret;
-  auto Block = Inst->getParent();
-  for (auto Iter = Block->begin(), End = Block->end(); Iter != End; ++Iter) {
-    if (&(*Iter) == Inst) {
-      ++Iter;
-      if (Iter != End) {
-        Ret.push_back(&(*Iter));
-        return Ret;
-      }
-      for (auto Succ = succ_begin(Block), BS = succ_end(Block); Succ != BS;
-           ++Succ) {
-        Ret.push_back(&(*((*Succ)->begin())));
-      }
-      return Ret;
-    }
+  if (auto Next = Inst->getNextNode()) {
+    Ret.push_back(Next);
+    return Ret;
+  }
+  for (auto Succ : successors(Inst->getParent())) {
+    Ret.push_back(&Succ->front());
   }
   return Ret;
 }
@@ -67,11 +51,12 @@ Memory *join(Memory *Mem1, Memory *Mem2) {
   /**
    * TODO: Write your code that joins two memories.
    *
-   * If some instruction with domain D is either in Mem1 or Mem2, but not in
-   *   both, add it with domain D to the Result.
-   * If some instruction is present in Mem1 with domain D1 and in Mem2 with
-   *   domain D2, then Domain::join D1 and D2 to find the new domain D,
-   *   and add instruction I with domain D to the Result.
+   * Return a new Memory in which every variable has the Domain::join of its
+   *   domains in Mem1 and Mem2. A variable missing from one memory is
+   *   Uninit there.
+   *
+   * Hint: Memory::join joins a whole memory into another, a machine word at
+   *   a time.
    */
   return NULL;
 }
@@ -98,11 +83,10 @@ bool equal(Memory *Mem1, Memory *Mem2) {
   /**
    * TODO: Write your code to implement check for equality of two memories.
    *
-   * If any instruction I is present in one of Mem1 or Mem2,
-   *   but not in both and the Domain of I is not UnInit, the memories are
-   *   unequal.
-   * If any instruction I is present in Mem1 with domain D1 and in Mem2
-   *   with domain D2, if D1 and D2 are unequal, then the memories are unequal.
+   * Two memories are equal if every variable has equal domains in Mem1 and
+   *   Mem2. A variable missing from one memory is Uninit there.
+   *
+   * Hint: Memory::operator== compares two memories a machine word at a time.
    */
   return false;
 }
@@ -142,4 +126,4 @@ void DivZeroAnalysis::doAnalysis(Function &F, PointerAnalysis *PA) {
    */
 }
 
-} // namespace dataflow
\ No newline at end of file
+} // namespace dataflow
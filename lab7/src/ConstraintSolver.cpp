@@ -0,0 +1,184 @@
+#include "ConstraintSolver.h"
+
+#include "llvm/ADT/DenseMap.h"
+
+#include <algorithm>
+
+namespace dataflow {
+
+unsigned ConstraintSolver::makeNode() {
+  Nodes.emplace_back();
+  Rep.push_back(Nodes.size() - 1);
+  Queued.push_back(false);
+  return Nodes.size() - 1;
+}
+
+void ConstraintSolver::addAddressOf(unsigned Ptr, unsigned Obj) {
+  include(find(Ptr), Sets.singleton(Obj));
+}
+
+void ConstraintSolver::addCopy(unsigned Dst, unsigned Src) {
+  addEdge(Src, Dst);
+}
+
+void ConstraintSolver::addLoad(unsigned Dst, unsigned Ptr) {
+  Ptr = find(Ptr);
+  Nodes[Ptr].LoadsTo.push_back(Dst);
+  // Objects already propagated by Ptr would not be visited again.
+  for (unsigned Obj : Sets.get(Nodes[Ptr].Propagated))
+    addEdge(Obj, Dst);
+}
+
+void ConstraintSolver::addStore(unsigned Ptr, unsigned Src) {
+  Ptr = find(Ptr);
+  Nodes[Ptr].StoresFrom.push_back(Src);
+  for (unsigned Obj : Sets.get(Nodes[Ptr].Propagated))
+    addEdge(Src, Obj);
+}
+
+void ConstraintSolver::push(unsigned N) {
+  if (Queued[N])
+    return;
+  Queued[N] = true;
+  WorkList.push_back(N);
+}
+
+unsigned ConstraintSolver::find(unsigned N) {
+  unsigned Root = getRep(N);
+  while (Rep[N] != Root) {
+    unsigned Next = Rep[N];
+    Rep[N] = Root;
+    N = Next;
+  }
+  return Root;
+}
+
+void ConstraintSolver::addEdge(unsigned From, unsigned To) {
+  From = find(From);
+  To = find(To);
+  if (From == To || !Nodes[From].Succs.insert(To))
+    return;
+  // The delta of From, if any, will flow along the edge when From is
+  // visited; only what it already propagated has to be sent now.
+  include(To, Nodes[From].Propagated);
+}
+
+void ConstraintSolver::include(unsigned N, SetID Set) {
+  SetID Joined = Sets.unite(Nodes[N].PointsTo, Set);
+  if (Joined == Nodes[N].PointsTo)
+    return;
+  Nodes[N].PointsTo = Joined;
+  push(N);
+}
+
+void ConstraintSolver::unite(unsigned N, unsigned Other) {
+  Node &Into = Nodes[N];
+  Node &From = Nodes[Other];
+  Rep[Other] = N;
+  Into.PointsTo = Sets.unite(Into.PointsTo, From.PointsTo);
+  // Each edge of the merged node has received what its own end propagated,
+  // so only what both propagated is known to have reached all of them.
+  Into.Propagated = Sets.intersect(Into.Propagated, From.Propagated);
+  for (unsigned Succ : From.Succs)
+    Into.Succs.insert(Succ);
+  Into.LoadsTo.insert(Into.LoadsTo.end(), From.LoadsTo.begin(),
+                      From.LoadsTo.end());
+  Into.StoresFrom.insert(Into.StoresFrom.end(), From.StoresFrom.begin(),
+                         From.StoresFrom.end());
+  From = Node();
+  push(N);
+}
+
+void ConstraintSolver::collapseCycles(unsigned Start) {
+  DenseMap<unsigned, unsigned> Index;
+  DenseMap<unsigned, unsigned> Low;
+  std::vector<unsigned> Stack;
+  DenseSet<unsigned> OnStack;
+  // Nodes being visited, with the index of their next successor.
+  std::vector<std::pair<unsigned, unsigned>> Path;
+  unsigned Count = 0;
+
+  auto Visit = [&](unsigned N) {
+    Index[N] = Count;
+    Low[N] = Count;
+    ++Count;
+    Stack.push_back(N);
+    OnStack.insert(N);
+    Path.push_back(std::make_pair(N, 0u));
+  };
+
+  Visit(find(Start));
+  while (!Path.empty()) {
+    unsigned N = Path.back().first;
+    unsigned I = Path.back().second;
+    if (I < Nodes[N].Succs.size()) {
+      ++Path.back().second;
+      unsigned W = find(Nodes[N].Succs[I]);
+      if (W == N)
+        continue;
+      if (!Index.count(W))
+        Visit(W);
+      else if (OnStack.count(W))
+        Low[N] = std::min(Low[N], Index[W]);
+      continue;
+    }
+
+    Path.pop_back();
+    if (!Path.empty()) {
+      unsigned Parent = Path.back().first;
+      Low[Parent] = std::min(Low[Parent], Low[N]);
+    }
+    if (Low[N] != Index[N])
+      continue;
+    // N is the root of an SCC, whose other nodes are above it on Stack.
+    while (true) {
+      unsigned W = Stack.back();
+      Stack.pop_back();
+      OnStack.erase(W);
+      if (W == N)
+        break;
+      unite(N, W);
+    }
+  }
+}
+
+void ConstraintSolver::solve() {
+  while (!WorkList.empty()) {
+    unsigned N = WorkList.front();
+    WorkList.pop_front();
+    Queued[N] = false;
+    if (Rep[N] != N)
+      continue;
+
+    SetID Delta = Sets.subtract(Nodes[N].PointsTo, Nodes[N].Propagated);
+    if (Delta == NodeSetTable::Empty)
+      continue;
+    // Propagated is always a subset of PointsTo.
+    Nodes[N].Propagated = Nodes[N].PointsTo;
+
+    // New targets of N give new edges for its loads and stores.
+    for (unsigned Obj : Sets.get(Delta)) {
+      for (unsigned Dst : Nodes[N].LoadsTo)
+        addEdge(Obj, Dst);
+      for (unsigned Src : Nodes[N].StoresFrom)
+        addEdge(Src, Obj);
+    }
+    // Successors are indexed, as those edges may add successors to N itself.
+    // Cycles are only collapsed once Delta reached every successor, since
+    // merging assumes that whatever a node propagated reached all its edges.
+    std::vector<unsigned> CycleCandidates;
+    for (size_t I = 0; I < Nodes[N].Succs.size(); ++I) {
+      unsigned Succ = find(Nodes[N].Succs[I]);
+      if (Succ == N)
+        continue;
+      include(Succ, Delta);
+      if (Nodes[Succ].PointsTo == Nodes[N].PointsTo &&
+          Checked.insert(std::make_pair(N, Succ)).second)
+        CycleCandidates.push_back(Succ);
+    }
+    for (unsigned Succ : CycleCandidates)
+      collapseCycles(Succ);
+  }
+}
+
+} // namespace dataflow
@@ -0,0 +1,260 @@
+#include "DemandSolver.h"
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/STLExtras.h"
+
+#include <deque>
+
+namespace dataflow {
+
+unsigned DemandSolver::makeNode() {
+  invalidate();
+  Nodes.emplace_back();
+  return Nodes.size() - 1;
+}
+
+void DemandSolver::addAddressOf(unsigned Ptr, unsigned Obj) {
+  invalidate();
+  Nodes[Ptr].Objects.push_back(Obj);
+  Nodes[Obj].Object = true;
+}
+
+void DemandSolver::addCopy(unsigned Dst, unsigned Src) {
+  invalidate();
+  Nodes[Dst].CopyFrom.push_back(Src);
+}
+
+void DemandSolver::addLoad(unsigned Dst, unsigned Ptr) {
+  invalidate();
+  Nodes[Dst].LoadFrom.push_back(Ptr);
+}
+
+void DemandSolver::addStore(unsigned Ptr, unsigned Src) {
+  invalidate();
+  Stores.push_back(std::make_pair(Ptr, Src));
+}
+
+void DemandSolver::invalidate() {
+  if (!Queried)
+    return;
+  PointsTo.clear();
+  Solved.clear();
+  DirectStores.clear();
+  IndirectStores.clear();
+  Queried = false;
+}
+
+void DemandSolver::solve() {}
+
+void DemandSolver::indexStores() const {
+  for (auto &Store : Stores) {
+    const Node &Ptr = Nodes[Store.first];
+    if (!Ptr.CopyFrom.empty() || !Ptr.LoadFrom.empty()) {
+      IndirectStores.push_back(Store);
+      continue;
+    }
+    for (unsigned Obj : Ptr.Objects)
+      DirectStores[Obj].push_back(Store.second);
+  }
+}
+
+const NodeSet &DemandSolver::getPointsTo(unsigned N) const {
+  if (!Queried) {
+    Queried = true;
+    PointsTo.resize(Nodes.size());
+    Solved.resize(Nodes.size());
+    indexStores();
+  }
+  if (!Solved[N] && !query(N))
+    solveExhaustively();
+  return PointsTo[N];
+}
+
+void DemandSolver::solveExhaustively() const {
+  ConstraintSolver Solver;
+  for (unsigned N = 0, E = Nodes.size(); N < E; ++N)
+    Solver.makeNode();
+  for (unsigned N = 0, E = Nodes.size(); N < E; ++N) {
+    for (unsigned Obj : Nodes[N].Objects)
+      Solver.addAddressOf(N, Obj);
+    for (unsigned Src : Nodes[N].CopyFrom)
+      Solver.addCopy(N, Src);
+    for (unsigned Ptr : Nodes[N].LoadFrom)
+      Solver.addLoad(N, Ptr);
+  }
+  for (auto &Store : Stores)
+    Solver.addStore(Store.first, Store.second);
+  Solver.solve();
+
+  for (unsigned N = 0, E = Nodes.size(); N < E; ++N) {
+    PointsTo[N] = Solver.getPointsTo(N);
+    Solved[N] = true;
+  }
+}
+
+namespace {
+
+/**
+ * @brief State of one query: the nodes it visits, with the edges between
+ * them, solved with a worklist. Solved nodes are not visited; their sets
+ * are final, so they are included whole into their successors.
+ */
+struct Query {
+  std::vector<NodeSet> &PointsTo;
+  const std::vector<bool> &Solved;
+
+  DenseSet<unsigned> Visited;
+  std::vector<unsigned> ToExpand;
+  DenseMap<unsigned, SmallVector<unsigned, 2>> Succs;
+  DenseMap<unsigned, NodeSet> Propagated;
+  /// Loads through each pointer, and values stored through it by the
+  /// indirect stores.
+  DenseMap<unsigned, SmallVector<unsigned, 1>> LoadsOf;
+  DenseMap<unsigned, SmallVector<unsigned, 1>> StoresOf;
+  /// Objects visited, whose stores must all be found.
+  DenseSet<unsigned> Read;
+  bool StoresVisited = false;
+  std::deque<unsigned> WorkList;
+  DenseSet<unsigned> Queued;
+  unsigned Cost = 0;
+
+  Query(std::vector<NodeSet> &PointsTo, const std::vector<bool> &Solved)
+      : PointsTo(PointsTo), Solved(Solved) {}
+
+  /// Part of the set of N that its successors have received.
+  const NodeSet &getPropagated(unsigned N) {
+    return Solved[N] ? PointsTo[N] : Propagated[N];
+  }
+
+  void visit(unsigned N) {
+    if (Solved[N] || !Visited.insert(N).second)
+      return;
+    ++Cost;
+    ToExpand.push_back(N);
+  }
+
+  void push(unsigned N) {
+    if (Queued.insert(N).second)
+      WorkList.push_back(N);
+  }
+
+  void include(unsigned N, const NodeSet &Set) {
+    if (PointsTo[N] |= Set)
+      push(N);
+  }
+
+  void addEdge(unsigned From, unsigned To) {
+    SmallVector<unsigned, 2> &FromSuccs = Succs[From];
+    if (is_contained(FromSuccs, To))
+      return;
+    ++Cost;
+    FromSuccs.push_back(To);
+    include(To, getPropagated(From));
+  }
+};
+
+} // namespace
+
+bool DemandSolver::query(unsigned Start) const {
+  Query Q(PointsTo, Solved);
+
+  // The memory of Obj is visited: the values stored into it flow into it.
+  auto FindStores = [&](unsigned Obj) {
+    Q.Read.insert(Obj);
+    auto Direct = DirectStores.find(Obj);
+    if (Direct != DirectStores.end()) {
+      for (unsigned Src : Direct->second) {
+        Q.visit(Src);
+        Q.addEdge(Src, Obj);
+      }
+    }
+    if (!Q.StoresVisited) {
+      Q.StoresVisited = true;
+      for (auto &Store : IndirectStores) {
+        Q.visit(Store.first);
+        Q.StoresOf[Store.first].push_back(Store.second);
+      }
+    }
+    // Pointers that already propagated Obj would not be seen again.
+    for (auto &Store : IndirectStores) {
+      if (Q.getPropagated(Store.first).test(Obj)) {
+        Q.visit(Store.second);
+        Q.addEdge(Store.second, Obj);
+      }
+    }
+  };
+
+  Q.visit(Start);
+  while (!Q.ToExpand.empty() || !Q.WorkList.empty()) {
+    if (Q.Cost > Budget) {
+      for (unsigned N : Q.Visited)
+        PointsTo[N].clear();
+      return false;
+    }
+
+    if (!Q.ToExpand.empty()) {
+      unsigned N = Q.ToExpand.back();
+      Q.ToExpand.pop_back();
+      const Node &Current = Nodes[N];
+      for (unsigned Obj : Current.Objects)
+        PointsTo[N].set(Obj);
+      Q.push(N);
+      if (Current.Object)
+        FindStores(N);
+      for (unsigned Src : Current.CopyFrom) {
+        Q.visit(Src);
+        Q.addEdge(Src, N);
+      }
+      for (unsigned Ptr : Current.LoadFrom) {
+        Q.visit(Ptr);
+        Q.LoadsOf[Ptr].push_back(N);
+        NodeSet Seen = Q.getPropagated(Ptr);
+        for (unsigned Obj : Seen) {
+          Q.visit(Obj);
+          Q.addEdge(Obj, N);
+        }
+      }
+      continue;
+    }
+
+    unsigned N = Q.WorkList.front();
+    Q.WorkList.pop_front();
+    Q.Queued.erase(N);
+    NodeSet Delta;
+    Delta.intersectWithComplement(PointsTo[N], Q.Propagated[N]);
+    if (Delta.empty())
+      continue;
+    Q.Propagated[N] |= Delta;
+
+    for (unsigned Succ : Q.Succs[N])
+      Q.include(Succ, Delta);
+    auto Loads = Q.LoadsOf.find(N);
+    if (Loads != Q.LoadsOf.end()) {
+      for (unsigned Obj : Delta) {
+        for (unsigned Dst : Loads->second) {
+          Q.visit(Obj);
+          Q.addEdge(Obj, Dst);
+        }
+      }
+    }
+    auto Srcs = Q.StoresOf.find(N);
+    if (Srcs != Q.StoresOf.end()) {
+      for (unsigned Obj : Delta) {
+        if (!Q.Read.count(Obj))
+          continue;
+        for (unsigned Src : Srcs->second) {
+          Q.visit(Src);
+          Q.addEdge(Src, Obj);
+        }
+      }
+    }
+  }
+
+  // Everything the visited nodes depend on was visited too, so their sets
+  // are complete.
+  for (unsigned N : Q.Visited)
+    Solved[N] = true;
+  return true;
+}
+
+} // namespace dataflow
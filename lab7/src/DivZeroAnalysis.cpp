@@ -1,8 +1,43 @@
 #include "DivZeroAnalysis.h"
 #include "Utils.h"
 
+#include "llvm/Support/CommandLine.h"
+
 namespace dataflow {
 
+enum class SolverKind { Instruction, Block };
+
+// The block solver and MemoryFlow are reference solvers, and can only be
+// chosen if the pass is built with -DUSE_REFERENCE=ON.
+#ifdef USE_REFERENCE
+static cl::opt<SolverKind> Solver(
+    "divzero-solver", cl::desc("Fixpoint solver used by the DivZero analysis"),
+    cl::values(clEnumValN(SolverKind::Instruction, "instruction",
+                          "Chaotic iteration over instructions (doAnalysis)"),
+               clEnumValN(SolverKind::Block, "block",
+                          "Reverse-postorder worklist over basic blocks")),
+    cl::init(SolverKind::Instruction));
+
+enum class MemoryKind { PointsTo, MemorySSA };
+
+static cl::opt<MemoryKind> MemoryModel(
+    "divzero-memory",
+    cl::desc("How the block solver gives loads the values of the stores"),
+    cl::values(clEnumValN(MemoryKind::PointsTo, "points-to",
+                          "Stores update every may-alias pointer (transfer)"),
+               clEnumValN(MemoryKind::MemorySSA, "memoryssa",
+                          "Loads join the stores reaching them in MemorySSA")),
+    cl::init(MemoryKind::PointsTo));
+#else
+static const SolverKind Solver = SolverKind::Instruction;
+#endif
+
+static cl::opt<std::string> CacheDir(
+    "divzero-cache-dir",
+    cl::desc("Directory in which to cache the result of every function, so "
+             "that unchanged functions are not analyzed again"),
+    cl::init(""));
+
 //===----------------------------------------------------------------------===//
 // DivZero Analysis Implementation
 //===----------------------------------------------------------------------===//
@@ -36,38 +71,150 @@ bool DivZeroAnalysis::check(Instruction *Inst) {
 
 bool DivZeroAnalysis::runOnFunction(Function &F) {
   outs() << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+  analyze(F, ModulePA);
+  printResults(F);
+  releaseResults(F);
+  return false;
+}
 
-  // Initializing InMap and OutMap.
-  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
-       ++Iter) {
-    auto Inst = &(*Iter);
-    InMap[Inst] = new Memory;
-    OutMap[Inst] = new Memory;
+void DivZeroAnalysis::analyze(Function &F, PointerAnalysis *PA) {
+  Numbering = new ValueNumbering(F);
+
+  // The points-to graph is built and printed even if the result is cached,
+  // so that the output is the same; a cached result replaces the fixpoint
+  // and the checks. Results that depend on the summaries of other functions
+  // are not cached, as the key only covers F.
+  std::unique_ptr<PointerAnalysis> Owned;
+  if (!PA) {
+    Owned.reset(new PointerAnalysis(F));
+    PA = Owned.get();
+  }
+  bool UseCache = !CacheDir.empty() && !Summaries;
+  std::string CacheKey;
+  bool Cached = false;
+  if (UseCache) {
+    AnalysisCache Cache(CacheDir);
+    std::string Options =
+        "solver=" + std::to_string(static_cast<int>(SolverKind(Solver)));
+#ifdef USE_REFERENCE
+    if (MemoryModel == MemoryKind::MemorySSA)
+      Options += ",memory=memoryssa";
+#endif
+    Options += "," + PointerAnalysis::getOptions();
+    CacheKey = Cache.getKey(F, Options);
+    Cached = loadCachedResult(F, Cache, CacheKey);
   }
 
-  // The chaotic iteration algorithm is implemented inside doAnalysis().
-  auto PA = new PointerAnalysis(F);
-  doAnalysis(F, PA);
+  if (!Cached) {
+    // Summaries are only applied by the block solver.
+    if (Solver == SolverKind::Instruction && !Summaries) {
+      // Initializing InMap and OutMap.
+      for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+           ++Iter) {
+        auto Inst = &(*Iter);
+        InMap[Inst] = new Memory;
+        OutMap[Inst] = new Memory;
+      }
 
-  // Check each instruction in function F for potential divide-by-zero error.
-  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
-       ++Iter) {
-    auto Inst = &(*Iter);
-    if (check(Inst))
-      ErrorInsts.insert(Inst);
+      // The chaotic iteration algorithm is implemented inside doAnalysis().
+      doAnalysis(F, PA);
+    } else {
+#ifdef USE_REFERENCE
+      // The fixpoint only tracks block states; the memory of each
+      // instruction is rebuilt once afterwards, for check() and printMap().
+      doBlockAnalysis(F, PA);
+      for (BasicBlock &BB : F)
+        materialize(&BB, PA);
+#endif
+    }
+
+    // Check each instruction in function F for potential divide-by-zero
+    // error.
+    for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+         ++Iter) {
+      auto Inst = &(*Iter);
+      if (check(Inst))
+        ErrorInsts.insert(Inst);
+    }
+    if (UseCache)
+      storeCachedResult(F, AnalysisCache(CacheDir), CacheKey);
   }
+  BlockIn.clear();
+  BlockPointerSet.clear();
+  Flow.reset();
+}
 
-  printMap(F, InMap, OutMap);
+void DivZeroAnalysis::printResults(Function &F) {
+  printMap(F, InMap, OutMap, *Numbering);
   outs() << "Potential Instructions by " << getAnalysisName() << ": \n";
   for (auto Inst : ErrorInsts) {
     outs() << *Inst << "\n";
   }
+}
 
+void DivZeroAnalysis::releaseResults(Function &F) {
   for (auto Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
-    delete InMap[&(*Iter)];
-    delete OutMap[&(*Iter)];
+    delete InMap.lookup(&(*Iter));
+    delete OutMap.lookup(&(*Iter));
   }
-  return false;
+  InMap.clear();
+  OutMap.clear();
+  ErrorInsts.clear();
+  delete Numbering;
+  Numbering = nullptr;
+}
+
+#ifdef USE_REFERENCE
+void DivZeroAnalysis::buildMemoryFlow(Function &F, PointerAnalysis *PA) {
+  if (MemoryModel == MemoryKind::MemorySSA)
+    Flow.reset(new MemoryFlow(F, *PA));
+}
+#endif
+
+bool DivZeroAnalysis::loadCachedResult(Function &F, const AnalysisCache &Cache,
+                                       StringRef Key) {
+  CachedResult Result;
+  if (!Cache.load(Key, Result))
+    return false;
+
+  std::vector<Instruction *> Insts;
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+       ++Iter) {
+    Insts.push_back(&(*Iter));
+  }
+  if (Result.In.size() != Insts.size())
+    return false;
+  for (unsigned Index : Result.ErrorInsts) {
+    if (Index >= Insts.size())
+      return false;
+  }
+
+  for (unsigned I = 0, E = Insts.size(); I < E; ++I) {
+    InMap[Insts[I]] = new Memory(std::move(Result.In[I]));
+    OutMap[Insts[I]] = new Memory(std::move(Result.Out[I]));
+  }
+  for (unsigned Index : Result.ErrorInsts) {
+    ErrorInsts.insert(Insts[Index]);
+  }
+  return true;
+}
+
+void DivZeroAnalysis::storeCachedResult(Function &F,
+                                        const AnalysisCache &Cache,
+                                        StringRef Key) {
+  CachedResult Result;
+  DenseMap<Instruction *, unsigned> Index;
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End;
+       ++Iter) {
+    auto Inst = &(*Iter);
+    Index[Inst] = Result.In.size();
+    Result.In.push_back(*InMap[Inst]);
+    Result.Out.push_back(*OutMap[Inst]);
+  }
+  for (auto Inst : ErrorInsts) {
+    Result.ErrorInsts.push_back(Index[Inst]);
+  }
+  Cache.store(Key, Result);
 }
 
 char DivZeroAnalysis::ID = 1;
@@ -0,0 +1,90 @@
+#include "NodeSetTable.h"
+
+#include "llvm/ADT/Hashing.h"
+
+#include <algorithm>
+
+namespace dataflow {
+
+const NodeSetTable::ID NodeSetTable::Empty;
+
+static unsigned hashSet(const NodeSet &Set) {
+  hash_code Hash = hash_value(0u);
+  for (unsigned N : Set)
+    Hash = hash_combine(Hash, N);
+  return static_cast<unsigned>(static_cast<size_t>(Hash));
+}
+
+static std::pair<NodeSetTable::ID, NodeSetTable::ID>
+unorderedKey(NodeSetTable::ID A, NodeSetTable::ID B) {
+  return std::make_pair(std::min(A, B), std::max(A, B));
+}
+
+NodeSetTable::NodeSetTable() { intern(NodeSet()); }
+
+NodeSetTable::ID NodeSetTable::intern(NodeSet Set) {
+  SmallVector<ID, 1> &Bucket = Buckets[hashSet(Set)];
+  for (ID S : Bucket) {
+    if (Sets[S] == Set)
+      return S;
+  }
+  Sets.push_back(std::move(Set));
+  Bucket.push_back(Sets.size() - 1);
+  return Sets.size() - 1;
+}
+
+NodeSetTable::ID NodeSetTable::singleton(unsigned N) {
+  NodeSet Set;
+  Set.set(N);
+  return intern(std::move(Set));
+}
+
+NodeSetTable::ID NodeSetTable::unite(ID A, ID B) {
+  if (A == B || B == Empty)
+    return A;
+  if (A == Empty)
+    return B;
+  auto Key = unorderedKey(A, B);
+  auto It = Unions.find(Key);
+  if (It != Unions.end())
+    return It->second;
+  NodeSet Result = Sets[A];
+  Result |= Sets[B];
+  ID S = intern(std::move(Result));
+  Unions[Key] = S;
+  return S;
+}
+
+NodeSetTable::ID NodeSetTable::intersect(ID A, ID B) {
+  if (A == B)
+    return A;
+  if (A == Empty || B == Empty)
+    return Empty;
+  auto Key = unorderedKey(A, B);
+  auto It = Intersections.find(Key);
+  if (It != Intersections.end())
+    return It->second;
+  NodeSet Result = Sets[A];
+  Result &= Sets[B];
+  ID S = intern(std::move(Result));
+  Intersections[Key] = S;
+  return S;
+}
+
+NodeSetTable::ID NodeSetTable::subtract(ID A, ID B) {
+  if (A == B || A == Empty)
+    return Empty;
+  if (B == Empty)
+    return A;
+  auto Key = std::make_pair(A, B);
+  auto It = Differences.find(Key);
+  if (It != Differences.end())
+    return It->second;
+  NodeSet Result;
+  Result.intersectWithComplement(Sets[A], Sets[B]);
+  ID S = intern(std::move(Result));
+  Differences[Key] = S;
+  return S;
+}
+
+} // namespace dataflow
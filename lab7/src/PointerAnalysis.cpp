@@ -1,94 +1,469 @@
 #include "PointerAnalysis.h"
+#include "UnificationSolver.h"
 #include "Utils.h"
 
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/GlobalVariable.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/Support/CommandLine.h"
+
+#include <algorithm>
+#include <memory>
 
 namespace dataflow {
 
-void PointerAnalysis::transfer(Instruction *Inst, PointsToInfo &PointsTo) {
+enum class PTAKind { Andersen, Steensgaard, Demand };
+
+static cl::opt<PTAKind> PTA(
+    "pta", cl::desc("Pointer analysis used by the DivZero analysis"),
+    cl::values(clEnumValN(PTAKind::Andersen, "andersen",
+                          "Inclusion-based, with a constraint graph"),
+               clEnumValN(PTAKind::Steensgaard, "steens",
+                          "Unification-based: almost linear time, less "
+                          "precise"),
+               clEnumValN(PTAKind::Demand, "demand",
+                          "Inclusion-based, solving only what alias "
+                          "queries need")),
+    cl::init(PTAKind::Andersen));
+
+static cl::opt<unsigned> DemandBudget(
+    "pta-demand-budget",
+    cl::desc("Nodes and edges a -pta=demand query may visit before the "
+             "whole graph is solved instead"),
+    cl::init(10000));
+
+static std::unique_ptr<PointsToSolver> makeSolver() {
+  if (PTA == PTAKind::Steensgaard)
+    return std::unique_ptr<PointsToSolver>(new UnificationSolver());
+  if (PTA == PTAKind::Demand)
+    return std::unique_ptr<PointsToSolver>(new DemandSolver(DemandBudget));
+  return std::unique_ptr<PointsToSolver>(new ConstraintSolver());
+}
+
+std::string PointerAnalysis::getOptions() {
+  switch (PTA) {
+  case PTAKind::Steensgaard:
+    return "pta=steens";
+  case PTAKind::Demand:
+    return "pta=demand,pta-demand-budget=" + std::to_string(DemandBudget);
+  default:
+    return "pta=andersen";
+  }
+}
+
+/**
+ * @brief Function of which Val is a variable, if any.
+ */
+static const Function *getParentFunction(const Value *Val) {
+  if (auto Inst = dyn_cast<Instruction>(Val))
+    return Inst->getFunction();
+  if (auto Arg = dyn_cast<Argument>(Val))
+    return Arg->getParent();
+  return nullptr;
+}
+
+/**
+ * @brief Is Call an allocation site, i.e. does it return new memory?
+ */
+static bool isAllocation(const CallInst *Call) {
+  const Function *Callee = Call->getCalledFunction();
+  return Callee && Callee->isDeclaration() &&
+         Call->getType()->isPointerTy() &&
+         Call->hasRetAttr(Attribute::NoAlias);
+}
+
+std::string PointerAnalysis::getName(const Value *Val, bool Object) const {
+  if (!WholeModule)
+    return Object ? address(Val) : variable(Val);
+  // Printing whole instructions would go over the types of the module each
+  // time, so values are named by their operand, qualified by function.
+  const Function *F = getParentFunction(Val);
+  if (F)
+    Slots->incorporateFunction(*F);
+  std::string Name;
+  raw_string_ostream SS(Name);
+  Val->printAsOperand(SS, false, *Slots);
+  SS.flush();
+  if (Object)
+    Name = "@(" + Name + ")";
+  return F ? F->getName().str() + ":" + Name : Name;
+}
+
+unsigned PointerAnalysis::addNode(std::string Name, const Value *Val,
+                                  PointsToSolver &Solver) {
+  unsigned N = Solver.makeNode();
+  Numbers[Name] = N;
+  Names.push_back(std::move(Name));
+  ValueOf.push_back(Val);
+  return N;
+}
+
+unsigned PointerAnalysis::getVariable(const Value *Val,
+                                      PointsToSolver &Solver) {
+  auto It = Variables.find(Val);
+  if (It != Variables.end())
+    return It->second;
+  unsigned N = addNode(getName(Val, false), Val, Solver);
+  Variables[Val] = N;
+  if (!WholeModule)
+    return N;
+
+  // Globals are the address of their memory, and constant casts and GEPs
+  // copy their operands, like the instructions of the same name.
+  if (isa<GlobalValue>(Val)) {
+    auto Obj = Objects.find(Val);
+    if (Obj != Objects.end())
+      Solver.addAddressOf(N, Obj->second);
+  } else if (auto Expr = dyn_cast<ConstantExpr>(Val)) {
+    for (const Value *Op : Expr->operands()) {
+      if (Op->getType()->isPointerTy())
+        Solver.addCopy(N, getVariable(Op, Solver));
+    }
+  }
+  return N;
+}
+
+unsigned PointerAnalysis::getReturn(const Function *F,
+                                    PointsToSolver &Solver) {
+  auto It = Returns.find(F);
+  if (It != Returns.end())
+    return It->second;
+  unsigned N = addNode(F->getName().str() + ":<ret>", nullptr, Solver);
+  Returns[F] = N;
+  return N;
+}
+
+void PointerAnalysis::addConstraints(Instruction *Inst,
+                                     PointsToSolver &Solver) {
   if (AllocaInst *Alloca = dyn_cast<AllocaInst>(Inst)) {
-    std::string Pointer = variable(Alloca);
-    PointsToSet &S = PointsTo[variable(Alloca)];
-    S.insert(address(Alloca));
+    Solver.addAddressOf(getVariable(Alloca, Solver), Objects[Alloca]);
   } else if (StoreInst *Store = dyn_cast<StoreInst>(Inst)) {
     if (!Store->getValueOperand()->getType()->isPointerTy())
       return;
-    Value *Pointer = Store->getPointerOperand();
-    Value *Value = Store->getValueOperand();
-    PointsToSet &L = PointsTo[variable(Pointer)];
-    PointsToSet &R = PointsTo[variable(Value)];
-    for (auto &I : L) {
-      PointsToSet &S = PointsTo[I];
-      PointsToSet Result;
-      std::set_union(S.begin(), S.end(), R.begin(), R.end(),
-                     std::inserter(Result, Result.begin()));
-      PointsTo[I] = Result;
-    }
+    Solver.addStore(getVariable(Store->getPointerOperand(), Solver),
+                    getVariable(Store->getValueOperand(), Solver));
   } else if (LoadInst *Load = dyn_cast<LoadInst>(Inst)) {
     if (!Load->getType()->isPointerTy())
       return;
-    std::string Variable = variable(Load->getPointerOperand());
-    PointsToSet &R = PointsTo[Variable];
-    PointsToSet &L = PointsTo[variable(Load)];
-    PointsToSet Result;
-    for (auto &I : R) {
-      PointsToSet &S = PointsTo[I];
-      std::set_union(S.begin(), S.end(), Result.begin(), Result.end(),
-                     std::inserter(Result, Result.begin()));
+    Solver.addLoad(getVariable(Load, Solver),
+                   getVariable(Load->getPointerOperand(), Solver));
+  } else if (isa<CastInst>(Inst) || isa<GetElementPtrInst>(Inst) ||
+             isa<PHINode>(Inst) || isa<SelectInst>(Inst)) {
+    if (!Inst->getType()->isPointerTy())
+      return;
+    unsigned Dst = getVariable(Inst, Solver);
+    // The condition of a select is not a pointer, nor are GEP indices.
+    for (Value *Op : Inst->operands()) {
+      if (Op->getType()->isPointerTy())
+        Solver.addCopy(Dst, getVariable(Op, Solver));
     }
-    PointsTo[variable(Load)] = Result;
+  } else if (ReturnInst *Return = dyn_cast<ReturnInst>(Inst)) {
+    Value *Val = Return->getReturnValue();
+    if (!WholeModule || !Val || !Val->getType()->isPointerTy())
+      return;
+    Solver.addCopy(getReturn(Return->getFunction(), Solver),
+                   getVariable(Val, Solver));
   }
 }
 
-int PointerAnalysis::countFacts(PointsToInfo &PointsTo) {
-  int N = 0;
-  for (auto &I : PointsTo)
-    N += I.second.size();
-  return N;
+void PointerAnalysis::addCallConstraints(CallInst *Call,
+                                         PointsToSolver &Solver) {
+  auto Obj = Objects.find(Call);
+  if (Obj != Objects.end())
+    Solver.addAddressOf(getVariable(Call, Solver), Obj->second);
+
+  if (const Function *Callee = Call->getCalledFunction()) {
+    Callees[Call].push_back(Callee);
+    addCallee(Call, Callee, Solver);
+    return;
+  }
+  // The nodes of an indirect call are made now, as its targets are only
+  // known once the constraints are solved.
+  if (Call->getType()->isPointerTy())
+    getVariable(Call, Solver);
+  for (Value *Arg : Call->args()) {
+    if (Arg->getType()->isPointerTy())
+      getVariable(Arg, Solver);
+  }
+  Callees[Call];
+  IndirectCalls.push_back(
+      std::make_pair(Call, getVariable(Call->getCalledOperand(), Solver)));
+}
+
+void PointerAnalysis::addCallee(const CallInst *Call, const Function *Callee,
+                                PointsToSolver &Solver) {
+  if (Callee->isDeclaration())
+    return;
+  // Extra arguments of a variadic call have no parameter.
+  auto Param = Callee->arg_begin();
+  for (unsigned I = 0, E = std::min<size_t>(Call->arg_size(),
+                                            Callee->arg_size());
+       I < E; ++I, ++Param) {
+    const Value *Arg = Call->getArgOperand(I);
+    if (Arg->getType()->isPointerTy() && Param->getType()->isPointerTy())
+      Solver.addCopy(getVariable(&*Param, Solver), getVariable(Arg, Solver));
+  }
+  if (Call->getType()->isPointerTy() &&
+      Callee->getReturnType()->isPointerTy())
+    Solver.addCopy(getVariable(Call, Solver), getReturn(Callee, Solver));
+}
+
+bool PointerAnalysis::resolveIndirectCalls(PointsToSolver &Solver) {
+  bool Changed = false;
+  for (auto &Site : IndirectCalls) {
+    std::vector<const Function *> &Targets = Callees[Site.first];
+    // Adding constraints may drop the sets a DemandSolver computed.
+    NodeSet Pointees = Solver.getPointsTo(Site.second);
+    for (unsigned Obj : Pointees) {
+      auto It = FunctionObjects.find(Obj);
+      if (It == FunctionObjects.end() || is_contained(Targets, It->second))
+        continue;
+      Targets.push_back(It->second);
+      addCallee(Site.first, It->second, Solver);
+      Changed = true;
+    }
+  }
+  return Changed;
 }
 
-void PointerAnalysis::print(std::map<std::string, PointsToSet> &PointsTo) {
+void PointerAnalysis::addInitializer(unsigned Obj, const Constant *Init,
+                                     PointsToSolver &Solver) {
+  // Fields are not distinguished, so the pointers anywhere in an aggregate
+  // all go to the memory of the variable.
+  if (isa<ConstantAggregate>(Init)) {
+    for (const Value *Op : Init->operands())
+      addInitializer(Obj, cast<Constant>(Op), Solver);
+  } else if (Init->getType()->isPointerTy() &&
+             (isa<GlobalValue>(Init) || isa<ConstantExpr>(Init))) {
+    Solver.addCopy(Obj, getVariable(Init, Solver));
+  }
+}
+
+void PointerAnalysis::print() const {
+  if (Demand)
+    return;
+  auto ByName = [this](unsigned A, unsigned B) { return Names[A] < Names[B]; };
+  std::vector<unsigned> Shown;
+  for (unsigned N = 0, E = SetOf.size(); N < E; ++N) {
+    if (N >= NumObjects || !PointsTo[SetOf[N]].empty())
+      Shown.push_back(N);
+  }
+  std::sort(Shown.begin(), Shown.end(), ByName);
+
   errs() << "Pointer Analysis Results:\n";
-  for (auto &I : PointsTo) {
-    errs() << "  " << I.first << ": { ";
-    for (auto &J : I.second) {
-      errs() << J << "; ";
+  for (unsigned N : Shown) {
+    errs() << "  " << Names[N] << ": { ";
+    std::vector<unsigned> Targets;
+    for (unsigned Target : PointsTo[SetOf[N]])
+      Targets.push_back(Target);
+    std::sort(Targets.begin(), Targets.end(), ByName);
+    for (unsigned Target : Targets) {
+      errs() << Names[Target] << "; ";
     }
     errs() << "}\n";
   }
   errs() << "\n";
 }
 
-PointerAnalysis::PointerAnalysis(Function &F) {
-  int NumOfOldFacts = 0;
-  int NumOfNewFacts = 0;
+void PointerAnalysis::finish(std::unique_ptr<PointsToSolver> Solver,
+                             bool Print) {
+  if (PTA == PTAKind::Demand) {
+    Demand.reset(static_cast<DemandSolver *>(Solver.release()));
+    return;
+  }
+
+  // Keep one copy of each set the solver shares between nodes, e.g. the
+  // nodes of a collapsed cycle or of a unification class.
+  DenseMap<const PointsToSet *, unsigned> SetIndex;
+  SetOf.reserve(Solver->getNumNodes());
+  for (unsigned N = 0, E = Solver->getNumNodes(); N < E; ++N) {
+    const PointsToSet &Set = Solver->getPointsTo(N);
+    auto Inserted = SetIndex.insert(std::make_pair(&Set, PointsTo.size()));
+    if (Inserted.second)
+      PointsTo.push_back(Set);
+    SetOf.push_back(Inserted.first->second);
+  }
+  if (Print)
+    print();
+}
+
+PointerAnalysis::PointerAnalysis(Function &F, bool Print) {
+  std::unique_ptr<PointsToSolver> Solver = makeSolver();
+
+  for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
+    if (auto Alloca = dyn_cast<AllocaInst>(&*Iter))
+      Objects[Alloca] = addNode(address(Alloca), nullptr, *Solver);
+  }
+  NumObjects = Names.size();
+
+  for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
+    auto Inst = &*Iter;
+    addConstraints(Inst, *Solver);
+    if (auto Call = dyn_cast<CallInst>(Inst)) {
+      if (const Function *Callee = Call->getCalledFunction())
+        Callees[Call].push_back(Callee);
+    }
+  }
+  Solver->solve();
+  finish(std::move(Solver), Print);
+}
+
+PointerAnalysis::PointerAnalysis(Module &M, bool Print) : WholeModule(true) {
+  std::unique_ptr<PointsToSolver> Solver = makeSolver();
+  ModuleSlotTracker MST(&M);
+  Slots = &MST;
+
+  for (GlobalVariable &G : M.globals())
+    Objects[&G] = addNode(getName(&G, true), nullptr, *Solver);
+  for (Function &F : M) {
+    unsigned Obj = addNode(getName(&F, true), nullptr, *Solver);
+    Objects[&F] = Obj;
+    FunctionObjects[Obj] = &F;
+  }
+  for (Function &F : M) {
+    for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E;
+         ++Iter) {
+      auto Call = dyn_cast<CallInst>(&*Iter);
+      if (isa<AllocaInst>(&*Iter) || (Call && isAllocation(Call)))
+        Objects[&*Iter] = addNode(getName(&*Iter, true), nullptr, *Solver);
+    }
+  }
+  NumObjects = Names.size();
+
+  for (GlobalVariable &G : M.globals()) {
+    if (G.hasInitializer())
+      addInitializer(Objects[&G], G.getInitializer(), *Solver);
+  }
+  for (Function &F : M) {
+    // Parameters and returns are made now, as they may only be reached by
+    // an indirect call, once the constraints are solved.
+    for (Argument &Arg : F.args()) {
+      if (Arg.getType()->isPointerTy())
+        getVariable(&Arg, *Solver);
+    }
+    if (!F.isDeclaration() && F.getReturnType()->isPointerTy())
+      getReturn(&F, *Solver);
 
-  while (true) {
-    for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
+    for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E;
+         ++Iter) {
       auto Inst = &*Iter;
-      transfer(Inst, PointsTo);
+      addConstraints(Inst, *Solver);
+      if (auto Call = dyn_cast<CallInst>(Inst))
+        addCallConstraints(Call, *Solver);
     }
-    NumOfNewFacts = countFacts(PointsTo);
-    if (NumOfOldFacts < NumOfNewFacts)
-      NumOfOldFacts = NumOfNewFacts;
-    else
-      break;
   }
-  print(PointsTo);
+
+  Solver->solve();
+  while (resolveIndirectCalls(*Solver))
+    Solver->solve();
+  Slots = nullptr;
+  finish(std::move(Solver), Print);
+}
+
+bool PointerAnalysis::aliasSets(unsigned S1, unsigned S2) const {
+  if (S1 == S2)
+    return !PointsTo[S1].empty();
+  if (PointsTo[S1].empty() || PointsTo[S2].empty())
+    return false;
+  auto Key = std::make_pair(std::min(S1, S2), std::max(S1, S2));
+  std::lock_guard<std::mutex> Lock(CacheLock);
+  auto It = AliasCache.find(Key);
+  if (It != AliasCache.end())
+    return It->second;
+  bool Result = PointsTo[S1].intersects(PointsTo[S2]);
+  AliasCache[Key] = Result;
+  return Result;
+}
+
+bool PointerAnalysis::aliasNodes(unsigned N1, unsigned N2) const {
+  if (!Demand)
+    return aliasSets(SetOf[N1], SetOf[N2]);
+  auto Key = std::make_pair(std::min(N1, N2), std::max(N1, N2));
+  std::lock_guard<std::mutex> Lock(CacheLock);
+  auto It = AliasCache.find(Key);
+  if (It != AliasCache.end())
+    return It->second;
+  const NodeSet &Set1 = Demand->getPointsTo(N1);
+  bool Result = N1 == N2 ? !Set1.empty()
+                         : Set1.intersects(Demand->getPointsTo(N2));
+  AliasCache[Key] = Result;
+  return Result;
 }
 
 bool PointerAnalysis::alias(std::string &Ptr1, std::string &Ptr2) const {
-  if (PointsTo.find(Ptr1) == PointsTo.end() ||
-      PointsTo.find(Ptr2) == PointsTo.end())
+  auto It1 = Numbers.find(Ptr1), It2 = Numbers.find(Ptr2);
+  if (It1 == Numbers.end() || It2 == Numbers.end())
     return false;
-  const PointsToSet &S1 = PointsTo.at(Ptr1);
-  const PointsToSet &S2 = PointsTo.at(Ptr2);
+  return aliasNodes(It1->second, It2->second);
+}
+
+bool PointerAnalysis::alias(const Value *Ptr1, const Value *Ptr2) const {
+  auto It1 = Variables.find(Ptr1), It2 = Variables.find(Ptr2);
+  if (It1 == Variables.end() || It2 == Variables.end())
+    return false;
+  return aliasNodes(It1->second, It2->second);
+}
+
+ArrayRef<const Value *>
+PointerAnalysis::getMayAliases(const Value *Ptr, const Function *F) const {
+  auto It = Variables.find(Ptr);
+  if (It == Variables.end())
+    return None;
+  unsigned Set = Demand ? It->second : SetOf[It->second];
+  std::lock_guard<std::mutex> Lock(CacheLock);
+  auto Inserted = MayAliases.insert(
+      std::make_pair(std::make_pair(Set, F), std::vector<const Value *>()));
+  std::vector<const Value *> &Result = Inserted.first->second;
+  if (!Inserted.second)
+    return Result;
+
+  if (Demand) {
+    // Only the variables of F are queried, rather than every pointer that
+    // points to the same objects.
+    const NodeSet &Targets = Demand->getPointsTo(It->second);
+    if (Targets.empty())
+      return Result;
+    if (VariablesOf.empty()) {
+      for (unsigned N = NumObjects, E = Names.size(); N < E; ++N) {
+        if (!ValueOf[N])
+          continue;
+        VariablesOf[getParentFunction(ValueOf[N])].push_back(N);
+        VariablesOf[nullptr].push_back(N);
+      }
+    }
+    for (unsigned N : VariablesOf[F]) {
+      if (Demand->getPointsTo(N).intersects(Targets))
+        Result.push_back(ValueOf[N]);
+    }
+    return Result;
+  }
+
+  if (PointedBy.empty()) {
+    PointedBy.resize(NumObjects);
+    for (unsigned N = NumObjects, E = SetOf.size(); N < E; ++N) {
+      for (unsigned Obj : PointsTo[SetOf[N]])
+        PointedBy[Obj].set(N);
+    }
+  }
+  NodeSet Aliases;
+  for (unsigned Obj : PointsTo[Set])
+    Aliases |= PointedBy[Obj];
+  for (unsigned N : Aliases) {
+    // Returns have no value.
+    if (ValueOf[N] && (!F || getParentFunction(ValueOf[N]) == F))
+      Result.push_back(ValueOf[N]);
+  }
+  return Result;
+}
 
-  PointsToSet Inter;
-  std::set_intersection(S1.begin(), S1.end(), S2.begin(), S2.end(),
-                        std::inserter(Inter, Inter.begin()));
-  return !Inter.empty();
+ArrayRef<const Function *>
+PointerAnalysis::getCallees(const CallInst *Call) const {
+  auto It = Callees.find(Call);
+  if (It == Callees.end())
+    return None;
+  return It->second;
 }
 
-}; // namespace dataflow
\ No newline at end of file
+}; // namespace dataflow
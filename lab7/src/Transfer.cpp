@@ -24,17 +24,19 @@ bool isInput(Instruction *Inst) {
  *
  * @param Phi PHINode to evaluate
  * @param InMem InMemory of Phi
+ * @param VN Numbering of the variables of the function
  * @return Domain of Phi
  */
-Domain *eval(PHINode *Phi, const Memory *InMem) {
+Domain eval(PHINode *Phi, const Memory *InMem,
+            const ValueNumbering &VN) {
   if (auto ConstantVal = Phi->hasConstantValue()) {
-    return new Domain(extractFromValue(ConstantVal));
+    return Domain(extractFromValue(ConstantVal));
   }
 
-  Domain *Joined = new Domain(Domain::Uninit);
+  Domain Joined(Domain::Uninit);
 
   for (unsigned int i = 0; i < Phi->getNumIncomingValues(); i++) {
-    auto Dom = getOrExtract(InMem, Phi->getIncomingValue(i));
+    auto Dom = getOrExtract(InMem, Phi->getIncomingValue(i), VN);
     Joined = Domain::join(Joined, Dom);
   }
   return Joined;
@@ -46,14 +48,16 @@ Domain *eval(PHINode *Phi, const Memory *InMem) {
  *
  * @param BinOp BinaryOperator to evaluate
  * @param InMem InMemory of BinOp
+ * @param VN Numbering of the variables of the function
  * @return Domain of BinOp
  */
-Domain *eval(BinaryOperator *BinOp, const Memory *InMem) {
+Domain eval(BinaryOperator *BinOp, const Memory *InMem,
+            const ValueNumbering &VN) {
   /**
    * TODO: Write your code here that evaluates +, -, * and /
    * based on the Domains of the operands.
    */
-  return NULL;
+  return Domain(Domain::Uninit);
 }
 
 /**
@@ -61,13 +65,15 @@ Domain *eval(BinaryOperator *BinOp, const Memory *InMem) {
  *
  * @param Cast Cast instruction to evaluate
  * @param InMem InMemory of Instruction
+ * @param VN Numbering of the variables of the function
  * @return Domain of Cast
  */
-Domain *eval(CastInst *Cast, const Memory *InMem) {
+Domain eval(CastInst *Cast, const Memory *InMem,
+            const ValueNumbering &VN) {
   /**
    * TODO: Write your code here to evaluate Cast instruction.
    */
-  return NULL;
+  return Domain(Domain::Uninit);
 }
 
 /**
@@ -76,9 +82,11 @@ Domain *eval(CastInst *Cast, const Memory *InMem) {
  *
  * @param Cmp Comparision instruction to evaluate
  * @param InMem InMemory of Cmp
+ * @param VN Numbering of the variables of the function
  * @return Domain of Cmp
  */
-Domain *eval(CmpInst *Cmp, const Memory *InMem) {
+Domain eval(CmpInst *Cmp, const Memory *InMem,
+            const ValueNumbering &VN) {
   /**
    * TODO: Write your code here that evaluates:
    * ==, !=, <, <=, >=, and > based on the Domains of the operands.
@@ -86,27 +94,27 @@ Domain *eval(CmpInst *Cmp, const Memory *InMem) {
    * NOTE: There is a lot of scope for refining this, but you can just return
    * MaybeZero for comparisons other than equality.
    */
-  return NULL;
+  return Domain(Domain::Uninit);
 }
 
 void DivZeroAnalysis::transfer(Instruction *Inst, const Memory *In,
                                Memory &NOut, PointerAnalysis *PA,
-                               SetVector<Value *> PointerSet) {
+                               const SetVector<Value *> &PointerSet) {
   if (isInput(Inst)) {
     // The instruction is a user controlled input, it can have any value.
-    NOut[variable(Inst)] = new Domain(Domain::MaybeZero);
+    NOut[Numbering->lookup(Inst)] = Domain(Domain::MaybeZero);
   } else if (auto Phi = dyn_cast<PHINode>(Inst)) {
     // Evaluate PHI node
-    NOut[variable(Phi)] = eval(Phi, In);
+    NOut[Numbering->lookup(Phi)] = eval(Phi, In, *Numbering);
   } else if (auto BinOp = dyn_cast<BinaryOperator>(Inst)) {
     // Evaluate BinaryOperator
-    NOut[variable(BinOp)] = eval(BinOp, In);
+    NOut[Numbering->lookup(BinOp)] = eval(BinOp, In, *Numbering);
   } else if (auto Cast = dyn_cast<CastInst>(Inst)) {
     // Evaluate Cast instruction
-    NOut[variable(Cast)] = eval(Cast, In);
+    NOut[Numbering->lookup(Cast)] = eval(Cast, In, *Numbering);
   } else if (auto Cmp = dyn_cast<CmpInst>(Inst)) {
     // Evaluate Comparision instruction
-    NOut[variable(Cmp)] = eval(Cmp, In);
+    NOut[Numbering->lookup(Cmp)] = eval(Cmp, In, *Numbering);
   } else if (auto Alloca = dyn_cast<AllocaInst>(Inst)) {
     // Do nothing here.
   } else if (auto Store = dyn_cast<StoreInst>(Inst)) {
@@ -117,8 +125,11 @@ void DivZeroAnalysis::transfer(Instruction *Inst, const Memory *In,
      * To build the abstract memory map, you need to ensure all pointer references are in-sync, and
      * will converge upon a precise abstract value. To achieve this, implement the following workflow:
      *
-     * Iterate through the provided PointerSet:
-     *   - If there is a may-alias (i.e., `alias()` returns true) between two variables:
+     * Iterate through the may-aliases of the pointer operand, i.e. the variables of
+     * the provided PointerSet for which `alias()` returns true. `PA->getMayAliases()`
+     * returns them directly, without testing every pair; pass it the function of Inst,
+     * as the points-to graph may cover the whole module:
+     *   - For each variable that may alias the pointer:
      *     + Get the abstract values of each variable.
      *     + Join the abstract values using Domain::join().
      *     + Update the memory map for the current assignment with the joined abstract value.
@@ -0,0 +1,118 @@
+#include "UnificationSolver.h"
+
+#include <utility>
+
+namespace dataflow {
+
+const unsigned UnificationSolver::None;
+
+unsigned UnificationSolver::makeNode() { return NumNodes++; }
+
+void UnificationSolver::addAddressOf(unsigned Ptr, unsigned Obj) {
+  Constraints.push_back({AddressOf, Ptr, Obj});
+}
+
+void UnificationSolver::addCopy(unsigned Dst, unsigned Src) {
+  Constraints.push_back({Copy, Dst, Src});
+}
+
+void UnificationSolver::addLoad(unsigned Dst, unsigned Ptr) {
+  Constraints.push_back({Load, Dst, Ptr});
+}
+
+void UnificationSolver::addStore(unsigned Ptr, unsigned Src) {
+  Constraints.push_back({Store, Ptr, Src});
+}
+
+unsigned UnificationSolver::makeClass() {
+  Rep.push_back(Rep.size());
+  Rank.push_back(0);
+  Pointee.push_back(None);
+  return Rep.size() - 1;
+}
+
+unsigned UnificationSolver::getRep(unsigned N) const {
+  while (Rep[N] != N)
+    N = Rep[N];
+  return N;
+}
+
+unsigned UnificationSolver::find(unsigned N) {
+  unsigned Root = getRep(N);
+  while (Rep[N] != Root) {
+    unsigned Next = Rep[N];
+    Rep[N] = Root;
+    N = Next;
+  }
+  return Root;
+}
+
+unsigned UnificationSolver::getPointee(unsigned N) {
+  N = find(N);
+  if (Pointee[N] == None) {
+    unsigned Class = makeClass();
+    Pointee[N] = Class;
+  }
+  return find(Pointee[N]);
+}
+
+void UnificationSolver::unify(unsigned A, unsigned B) {
+  // Merging two classes merges what they point to, which is done with a
+  // worklist rather than by recursion, as the chain can be long.
+  std::vector<std::pair<unsigned, unsigned>> WorkList;
+  WorkList.push_back(std::make_pair(A, B));
+  while (!WorkList.empty()) {
+    unsigned X = find(WorkList.back().first);
+    unsigned Y = find(WorkList.back().second);
+    WorkList.pop_back();
+    if (X == Y)
+      continue;
+    if (Rank[X] < Rank[Y])
+      std::swap(X, Y);
+    if (Rank[X] == Rank[Y])
+      ++Rank[X];
+    Rep[Y] = X;
+    if (Pointee[X] == None)
+      Pointee[X] = Pointee[Y];
+    else if (Pointee[Y] != None)
+      WorkList.push_back(std::make_pair(Pointee[X], Pointee[Y]));
+  }
+}
+
+void UnificationSolver::solve() {
+  while (Rep.size() < NumNodes)
+    makeClass();
+
+  for (const Constraint &C : Constraints) {
+    switch (C.K) {
+    case AddressOf:
+      unify(getPointee(C.Dst), C.Src);
+      break;
+    case Copy:
+      unify(getPointee(C.Dst), getPointee(C.Src));
+      break;
+    case Load:
+      unify(getPointee(C.Dst), getPointee(getPointee(C.Src)));
+      break;
+    case Store:
+      unify(getPointee(getPointee(C.Dst)), getPointee(C.Src));
+      break;
+    }
+  }
+  Constraints.clear();
+
+  // Only the nodes of the caller are members; the classes made up for
+  // unknown pointees have no node of their own.
+  Members.assign(Rep.size(), NodeSet());
+  for (unsigned N = 0; N < NumNodes; ++N)
+    Members[find(N)].set(N);
+}
+
+const NodeSet &UnificationSolver::getPointsTo(unsigned N) const {
+  unsigned Class = Pointee[getRep(N)];
+  if (Class == None)
+    return Empty;
+  return Members[getRep(Class)];
+}
+
+} // namespace dataflow
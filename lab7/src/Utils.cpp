@@ -5,21 +5,9 @@
 const char *WHITESPACES = " \t\n\r";
 const size_t VARIABLE_PADDED_LEN = 8;
 
-template <typename V, typename K, class Map, class DefaultConstructor>
-V getOrDefault(const Map *M, const K &Key, DefaultConstructor Default) {
-  const auto It = M->find(Key);
-  if (It == M->end())
-    return Default();
-
-  return It->second;
-}
-
 namespace dataflow {
 
-std::string variable(const Value *Val) {
-  std::string Code;
-  raw_string_ostream SS(Code);
-  Val->print(SS);
+static std::string variableName(std::string Code) {
   Code.erase(0, Code.find_first_not_of(WHITESPACES));
   auto RetVal = Code.substr(0, Code.find_first_of(WHITESPACES));
   if (RetVal == "ret" || RetVal == "br" || RetVal == "store") {
@@ -34,6 +22,20 @@ std::string variable(const Value *Val) {
   return RetVal;
 }
 
+std::string variable(const Value *Val) {
+  std::string Code;
+  raw_string_ostream SS(Code);
+  Val->print(SS);
+  return variableName(SS.str());
+}
+
+std::string variable(const Value *Val, ModuleSlotTracker &MST) {
+  std::string Code;
+  raw_string_ostream SS(Code);
+  Val->print(SS, MST);
+  return variableName(SS.str());
+}
+
 std::string address(const Value *Val) {
   std::string Code;
   raw_string_ostream SS(Code);
@@ -52,15 +54,21 @@ Domain::Element extractFromValue(const Value *Val) {
   return Domain::Uninit;
 }
 
-Domain *getOrExtract(const Memory *Mem, const Value *Val) {
-  return getOrDefault<Domain *>(Mem, variable(Val), [&V = Val] {
-    return new Domain(extractFromValue(V));
-  });
+Domain getOrExtract(const Memory *Mem, const Value *Val,
+                    const ValueNumbering &VN) {
+  unsigned N = VN.lookup(Val);
+  if (N == ValueNumbering::None) {
+    return Domain(extractFromValue(Val));
+  }
+  return Mem->get(N);
 }
 
-void printMemory(const Memory *Mem) {
-  for (auto Iter = Mem->begin(), End = Mem->end(); Iter != End; ++Iter) {
-    errs() << "    [ " << Iter->first << " |-> " << *Iter->second << " ]\n";
+void printMemory(const Memory *Mem, const ValueNumbering &VN) {
+  for (unsigned N = 0, End = Mem->size(); N < End; ++N) {
+    Domain D = Mem->get(N);
+    if (D.Value == Domain::Uninit)
+      continue;
+    errs() << "    [ " << VN.getName(N) << " |-> " << D << " ]\n";
   }
   if (Mem->empty()) {
     errs() << "\n";
@@ -68,26 +76,27 @@ void printMemory(const Memory *Mem) {
 }
 
 void printInstructionTransfer(Instruction *Inst, const Memory *InMem,
-                              const Memory *OutMem) {
-  auto InState = getOrExtract(InMem, Inst);
-  auto OutState = getOrExtract(OutMem, Inst);
+                              const Memory *OutMem, const ValueNumbering &VN) {
+  auto InState = getOrExtract(InMem, Inst, VN);
+  auto OutState = getOrExtract(OutMem, Inst, VN);
 
-  errs() << variable(Inst) << ":\t[ " << *InState << " --> " << *OutState
+  errs() << variable(Inst) << ":\t[ " << InState << " --> " << OutState
          << " ]\n";
 }
 
 void printMap(Function &F, ValueMap<Instruction *, Memory *> &InMap,
-              ValueMap<Instruction *, Memory *> &OutMap) {
+              ValueMap<Instruction *, Memory *> &OutMap,
+              const ValueNumbering &VN) {
   errs() << "Dataflow Analysis Results:\n";
   for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
     auto Inst = &(*Iter);
     errs() << "Instruction: " << *Inst << "\n";
     errs() << "In set: \n";
     auto InMem = InMap[Inst];
-    printMemory(InMem);
+    printMemory(InMem, VN);
     errs() << "Out set: \n";
     auto OutMem = OutMap[Inst];
-    printMemory(OutMem);
+    printMemory(OutMem, VN);
     errs() << "\n";
   }
 }
@@ -0,0 +1,42 @@
+#include "ValueNumbering.h"
+#include "Utils.h"
+
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/InstIterator.h"
+
+namespace dataflow {
+
+ValueNumbering::ValueNumbering(const Function &F) {
+  for (const Argument &Arg : F.args()) {
+    number(&Arg);
+  }
+  for (const Instruction &Inst : instructions(F)) {
+    for (const Value *Op : Inst.operand_values()) {
+      if (isa<GlobalVariable>(Op))
+        number(Op);
+    }
+    if (!Inst.getType()->isVoidTy())
+      number(&Inst);
+  }
+  Names.resize(Values.size());
+}
+
+void ValueNumbering::number(const Value *Val) {
+  if (Numbers.insert({Val, Values.size()}).second)
+    Values.push_back(Val);
+}
+
+unsigned ValueNumbering::lookup(const Value *Val) const {
+  auto It = Numbers.find(Val);
+  if (It == Numbers.end())
+    return None;
+  return It->second;
+}
+
+const std::string &ValueNumbering::getName(unsigned N) const {
+  if (Names[N].empty())
+    Names[N] = MST ? variable(Values[N], *MST) : variable(Values[N]);
+  return Names[N];
+}
+
+} // namespace dataflow
@@ -1,8 +1,54 @@
 #include "llvm/Support/raw_ostream.h"
+#include <array>
+#include <functional>
+#include <mutex>
 #include <set>
+#include <string>
 
 using namespace llvm;
 
+// Serialises writes to stderr; only taken when a whole line is printed.
+static std::mutex StderrLock;
+
+/**
+ * Per-thread stream that forwards complete lines to stderr, so that log
+ * lines of concurrent threads never interleave.
+ */
+class LineBufferedStream : public raw_ostream {
+public:
+  LineBufferedStream() { SetUnbuffered(); }
+  ~LineBufferedStream() override {
+    if (!Pending.empty())
+      emit(Pending.size());
+  }
+
+private:
+  std::string Pending;
+  uint64_t Written = 0;
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    Pending.append(Ptr, Size);
+    Written += Size;
+    size_t End = Pending.rfind('\n');
+    if (End != std::string::npos)
+      emit(End + 1);
+  }
+
+  uint64_t current_pos() const override { return Written; }
+
+  void emit(size_t Len) {
+    {
+      std::lock_guard<std::mutex> Guard(StderrLock);
+      llvm::errs().write(Pending.data(), Len);
+    }
+    Pending.erase(0, Len);
+  }
+};
+
+static raw_ostream &threadErrs() {
+  static thread_local LineBufferedStream Stream;
+  return Stream;
+}
 
 /**
  * Print in color to make your output more eye-catching:
@@ -12,38 +58,86 @@ using namespace llvm;
  * White -> Variable log printing
  */
 raw_ostream& errsYellow() {
-    llvm::errs() << "\033[33m";
-    return llvm::errs(); 
+    threadErrs() << "\033[33m";
+    return threadErrs(); 
 }
 
 raw_ostream& errsRed() {
-    llvm::errs() << "\033[31m";
-    return llvm::errs(); 
+    threadErrs() << "\033[31m";
+    return threadErrs(); 
 }
 
 raw_ostream& errsGreen() {
-    llvm::errs() << "\033[32m";
-    return llvm::errs(); 
+    threadErrs() << "\033[32m";
+    return threadErrs(); 
 }
 
 raw_ostream& errsWhite() {
-    llvm::errs() << "\033[0m";
-    return llvm::errs(); 
+    threadErrs() << "\033[0m";
+    return threadErrs(); 
 }
 
+/**
+ * A set split into independently locked shards, so that concurrent probes
+ * only contend when they touch keys of the same shard. insert(), erase() and
+ * count() behave like those of std::set; there are no iterators, since the
+ * other shards may change while one is walked.
+ */
+template <typename T> class ShardedSet {
+public:
+  bool insert(const T &Item) {
+    Shard &S = shardFor(Item);
+    std::lock_guard<std::mutex> Guard(S.Lock);
+    return S.Items.insert(Item).second;
+  }
+
+  size_t erase(const T &Item) {
+    Shard &S = shardFor(Item);
+    std::lock_guard<std::mutex> Guard(S.Lock);
+    return S.Items.erase(Item);
+  }
+
+  size_t count(const T &Item) {
+    Shard &S = shardFor(Item);
+    std::lock_guard<std::mutex> Guard(S.Lock);
+    return S.Items.count(Item);
+  }
+
+  bool contains(const T &Item) {
+    Shard &S = shardFor(Item);
+    std::lock_guard<std::mutex> Guard(S.Lock);
+    return S.Items.find(Item) != S.Items.end();
+  }
+
+private:
+  static const size_t NumShards = 64;
+
+  // Keep shards on separate cache lines to avoid false sharing of the locks.
+  struct alignas(64) Shard {
+    std::mutex Lock;
+    std::set<T> Items;
+  };
+
+  std::array<Shard, NumShards> Shards;
+
+  Shard &shardFor(const T &Item) {
+    return Shards[std::hash<T>()(Item) % NumShards];
+  }
+};
 
 extern "C" {
 	// taintedPtrVars stores the tainted memory address(for pointer type)
 	// taintedVars stores the name of the tainted variable(for non-pointer type)
-	std::set<void*> taintedPtrVars;
-	std::set<std::string> taintedVars;	
+	// Both are sharded so that probes of different threads rarely contend.
+	ShardedSet<void*> taintedPtrVars;
+	ShardedSet<std::string> taintedVars;
 
 
 	void TruncInstProcess(const char *destStr,const char *srcStr){
 		std::string srcString(srcStr);
 		std::string destString(destStr);
 		
-		if(taintedVars.find(srcString)!=taintedVars.end() ){
+		if(taintedVars.contains(srcString) ){
 			taintedVars.insert(destString);
 		
 			errsYellow()<< "Taint propagated from " << srcStr << " to " << destStr << "\n";
@@ -54,7 +148,7 @@ extern "C" {
 	void GEPInstProcess(void *destPtr, void * srcPtr, const char *destStr, const char *srcStr,bool offsetZero){
 		std::string srcString(srcStr);
 		std::string destString(destStr);
-		if(offsetZero && taintedPtrVars.find(srcPtr)!=taintedPtrVars.end() ){
+		if(offsetZero && taintedPtrVars.contains(srcPtr) ){
 			taintedPtrVars.insert(destPtr);
 		
 			errsYellow()<< "Taint propagated from " << srcPtr << " to " << destPtr << "\n";
@@ -69,6 +163,9 @@ extern "C" {
 		/**
 		 * TODO: Complete the taint propagation processing logic for StoreInst that stores non-pointer types.
 		 * 
+		 * taintedVars and taintedPtrVars are ShardedSets: use insert(), erase()
+		 * and contains() (or count()) on them, as you would on a std::set.
+		 * 
 		 * You can use the following two statements to output logs:
 		 * errsYellow()<< "Taint propagated from " << srcStr << " to " << destPtr << "\n";
 		 * errsWhite()<<"From :"<<srcString<<" "<<"to :"<<destString<<" "<<"\n";
@@ -84,6 +181,9 @@ extern "C" {
 		/**
 		 * TODO: Complete the taint propagation processing logic for StoreInst that stores pointer types.
 		 * 
+		 * taintedVars and taintedPtrVars are ShardedSets: use insert(), erase()
+		 * and contains() (or count()) on them, as you would on a std::set.
+		 * 
 		 * You can use the following two statements to output logs:
 		 * errsYellow()<< "Taint propagated from " << srcPtr << " to " << destPtr << "\n";
 		 * errsWhite()<<"From :"<<srcString<<" "<<"to :"<<destString<<" "<<"\n";
@@ -96,7 +196,7 @@ extern "C" {
 		std::string srcString(srcStr);
 		std::string destString(destStr);
 		
-		if(taintedPtrVars.find(srcPtr)!=taintedPtrVars.end() ){
+		if(taintedPtrVars.contains(srcPtr) ){
 			taintedVars.insert(destString);
 		
 			errsYellow()<< "Taint propagated from " << srcPtr << " to " << destStr << "\n";
@@ -113,6 +213,9 @@ extern "C" {
 		/**
 		 * TODO: Complete the taint propagation processing logic for BinaryOperator.
 		 * 
+		 * taintedVars and taintedPtrVars are ShardedSets: use insert(), erase()
+		 * and contains() (or count()) on them, as you would on a std::set.
+		 * 
 		 * You can use the following two statements to output logs:
 		 * errsYellow()<< "Taint propagated from " << srcString1+" , "+srcString2 << " to " << destString << "\n";
 		 * errsWhite()<<"From :"<<srcString1+" , "+srcString2<<" "<<"to :"<<destString<<" "<<"\n";
@@ -136,7 +239,7 @@ extern "C" {
 
 	void CheckVal(const char *srcStr) {
 		std::string srcString(srcStr);
-		if(taintedVars.find(srcStr)!=taintedVars.end()){
+		if(taintedVars.contains(srcStr)){
 			errsRed() << "Taint detected in sensitive position: " << srcStr << "!!!\n";
 		}
 		
@@ -144,7 +247,7 @@ extern "C" {
 
 	void CheckPtrVal(void * srcPtr,const char *srcStr) {
 		std::string srcString(srcStr);
-		if(taintedPtrVars.find(srcPtr)!=taintedPtrVars.end()){
+		if(taintedPtrVars.contains(srcPtr)){
 			errsRed()<< "Taint detected in sensitive position: " << srcPtr << "!!!\n";
 			errsWhite()<<"That's the address in:"<<srcString<<"\n";
 		}
@@ -154,7 +257,7 @@ extern "C" {
 	void StrcatProcess(void * destPtr, void * srcPtr, const char *destStr, const char *srcStr) {
 		std::string srcString(srcStr);
 		std::string destString(destStr);
-		if(taintedPtrVars.find(srcPtr)!=taintedPtrVars.end()){
+		if(taintedPtrVars.contains(srcPtr)){
 			taintedPtrVars.insert(destPtr);
 			
 			errsYellow()<< "Taint propagated from " << srcPtr << " to " << destPtr << "\n";